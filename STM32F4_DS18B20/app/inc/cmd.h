@@ -0,0 +1,65 @@
+/**
+ * @file:   cmd.h
+ * @brief:  Command dispatcher
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef CMD_H_
+#define CMD_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  CMD CMD
+ * @brief     Command dispatcher
+ */
+
+/**
+ * @addtogroup CMD
+ * @{
+ */
+
+#define CMD_MAX_ARGS 8 ///< Maximum number of command arguments
+
+/**
+ * @brief Parsed command argument.
+ */
+typedef union {
+  int32_t i;      ///< Integer argument (type 'i')
+  const char* s;  ///< Word argument (type 's')
+} CMD_Arg_TypeDef;
+
+/**
+ * @brief Command handler - gets number of arguments and parsed arguments.
+ */
+typedef void (*CMD_Handler)(uint8_t argc, CMD_Arg_TypeDef* argv);
+
+/**
+ * @brief Command execution results.
+ */
+typedef enum {
+  CMD_OK,           //!< CMD_OK           Command executed
+  CMD_EMPTY,        //!< CMD_EMPTY        Empty line
+  CMD_UNKNOWN,      //!< CMD_UNKNOWN      Unknown command
+  CMD_BAD_ARGS,     //!< CMD_BAD_ARGS     Wrong number or type of arguments
+} CMD_Result_TypeDef;
+
+uint8_t             CMD_Register  (const char* name, const char* args, CMD_Handler handler);
+CMD_Result_TypeDef  CMD_Execute   (char* line);
+
+/**
+ * @}
+ */
+
+#endif /* CMD_H_ */
@@ -19,10 +19,89 @@
 #define COMM_H_
 
 #include <inttypes.h>
+#include <fifo.h>
 
+#ifndef COMM_FRAME_MAX
+  #define COMM_FRAME_MAX  256    ///< Maximum frame length with terminator (longer frames are dropped)
+#endif
+
+/**
+ * @brief Policies for data which doesn't fit into TX buffer.
+ */
+typedef enum {
+  COMM_TX_DROP,   //!< COMM_TX_DROP   Data is dropped (default)
+  COMM_TX_BLOCK,  //!< COMM_TX_BLOCK  Wait for space, drop after timeout
+} COMM_TxPolicy_TypeDef;
+
+/**
+ * @brief COMM overflow statistics.
+ */
+typedef struct {
+  uint32_t txDropped;     ///< Bytes dropped - TX buffer full
+  uint32_t rxDropped;     ///< Bytes dropped - RX buffer full
+  uint32_t framesDropped; ///< Frames dropped - too long
+  uint32_t txTimeouts;    ///< Writes which timed out waiting for TX buffer space
+} COMM_Stats_TypeDef;
+
+/**
+ * @brief Communication channel.
+ * @details Every channel runs on its own port with its own
+ * buffers. Define a structure for each channel and pass it
+ * to COMM_ChannelInit - the fields are used internally.
+ */
+typedef struct {
+  uint8_t port;                   ///< Lower layer port
+  FIFO_TypeDef rxFifo;            ///< RX FIFO
+  FIFO_TypeDef txFifo;            ///< TX FIFO
+  volatile uint16_t gotFrame;     ///< Nonzero signals a new frame (number of received frames)
+  uint16_t frameLen;              ///< Length of frame to release from RX buffer
+  uint8_t  discarding;            ///< Nonzero - rest of an oversize frame is being dropped
+  uint32_t framesDropped;         ///< Number of dropped frames
+  COMM_TxPolicy_TypeDef txPolicy; ///< What to do with data not fitting into TX buffer
+  uint32_t txTimeout;             ///< Maximum time of waiting for TX buffer space in us
+  uint8_t  txStalled;             ///< Nonzero - last write timed out and TX buffer is still full
+  uint32_t txTimeouts;            ///< Number of writes which timed out
+  uint8_t  frameBuffer[COMM_FRAME_MAX]; ///< Buffer for frames wrapping around RX buffer end
+} COMM_Channel_TypeDef;
+
+uint8_t COMM_ChannelInit(COMM_Channel_TypeDef* ch, uint8_t port, uint32_t baud,
+    uint8_t* rxBuf, uint16_t rxLen, uint8_t* txBuf, uint16_t txLen);
+uint32_t COMM_ChannelCheckBaud(COMM_Channel_TypeDef* ch, uint32_t baud, int32_t* error);
+uint32_t COMM_ChannelSetBaud(COMM_Channel_TypeDef* ch, uint32_t baud);
+uint32_t COMM_ChannelGetBaud(COMM_Channel_TypeDef* ch);
+uint16_t COMM_ChannelWrite(COMM_Channel_TypeDef* ch, const uint8_t* buf, uint16_t len);
+uint8_t* COMM_ChannelTxReserve(COMM_Channel_TypeDef* ch, uint16_t len);
+uint16_t COMM_ChannelTxReserve2(COMM_Channel_TypeDef* ch, FIFO_Span_TypeDef* span);
+void    COMM_ChannelTxCommit(COMM_Channel_TypeDef* ch, uint16_t len);
+uint16_t COMM_ChannelGetTxFree(COMM_Channel_TypeDef* ch);
+uint8_t COMM_ChannelGetc(COMM_Channel_TypeDef* ch);
+uint8_t COMM_ChannelGetFrameRef(COMM_Channel_TypeDef* ch, uint8_t** buf, uint16_t* len);
+void    COMM_ChannelReleaseFrame(COMM_Channel_TypeDef* ch);
+uint8_t COMM_ChannelGetFrame(COMM_Channel_TypeDef* ch, uint8_t* buf, uint16_t maxLen, uint16_t* len);
+void    COMM_ChannelSetTxPolicy(COMM_Channel_TypeDef* ch, COMM_TxPolicy_TypeDef policy, uint32_t timeout);
+void    COMM_ChannelGetStats(COMM_Channel_TypeDef* ch, COMM_Stats_TypeDef* stats);
+void    COMM_ChannelGetBufferStats(COMM_Channel_TypeDef* ch, FIFO_Stats_TypeDef* rx, FIFO_Stats_TypeDef* tx);
+void    COMM_ChannelResetStats(COMM_Channel_TypeDef* ch);
+
+// console channel
 void    COMM_Init(uint32_t baud);
+void    COMM_ClockChanged(void);
+uint32_t COMM_CheckBaud(uint32_t baud, int32_t* error);
+uint32_t COMM_SetBaud(uint32_t baud);
+uint32_t COMM_GetBaud(void);
 void    COMM_Putc(uint8_t c);
+uint16_t COMM_Write(const uint8_t* buf, uint16_t len);
+uint16_t COMM_GetTxFree(void);
+uint8_t* COMM_TxReserve(uint16_t len);
+uint16_t COMM_TxReserve2(FIFO_Span_TypeDef* span);
+void    COMM_TxCommit(uint16_t len);
 uint8_t COMM_Getc(void);
-uint8_t COMM_GetFrame(uint8_t* buf, uint8_t* len);
+uint8_t COMM_GetFrame(uint8_t* buf, uint16_t maxLen, uint16_t* len);
+uint8_t COMM_GetFrameRef(uint8_t** buf, uint16_t* len);
+void    COMM_ReleaseFrame(void);
+void    COMM_SetTxPolicy(COMM_TxPolicy_TypeDef policy, uint32_t timeout);
+void    COMM_GetStats(COMM_Stats_TypeDef* stats);
+void    COMM_GetBufferStats(FIFO_Stats_TypeDef* rx, FIFO_Stats_TypeDef* tx);
+void    COMM_ResetStats(void);
 
 #endif /* COMM_H_ */
@@ -0,0 +1,46 @@
+/**
+ * @file:   defer.h
+ * @brief:  Deferred callback queue
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef DEFER_H_
+#define DEFER_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  DEFER DEFER
+ * @brief     Deferred callback queue
+ */
+
+/**
+ * @addtogroup DEFER
+ * @{
+ */
+
+/**
+ * @brief Deferred callback - gets the context pointer given when posting.
+ */
+typedef void (*DEFER_Callback)(void* ctx);
+
+uint8_t   DEFER_Post        (DEFER_Callback fun, void* ctx);
+uint8_t   DEFER_Run         (uint8_t maxItems);
+uint32_t  DEFER_GetDropped  (void);
+
+/**
+ * @}
+ */
+
+#endif /* DEFER_H_ */
@@ -21,6 +21,7 @@
 #include <inttypes.h>
 
 double  DS18B20_ReadTemp        (void);
+int16_t DS18B20_ReadTempRaw     (void);
 uint8_t DS18B20_Init            (void);
 void    DS18B20_ConversionStart (void);
 
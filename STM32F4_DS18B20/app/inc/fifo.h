@@ -30,21 +30,85 @@
  * @{
  */
 
+/**
+ * @brief FIFO overflow policies.
+ */
+typedef enum {
+  FIFO_DROP_NEWEST, //!< FIFO_DROP_NEWEST Data which doesn't fit is dropped (default)
+  FIFO_DROP_OLDEST, //!< FIFO_DROP_OLDEST Oldest data is overwritten
+} FIFO_Policy_TypeDef;
+
+#define FIFO_HIST_BINS 8 ///< Number of occupancy histogram bins
+
+/**
+ * @brief FIFO usage statistics.
+ * @details Occupancy is sampled by the producer after every push
+ * which stored data. The FIFO is full from a push which left no
+ * free space (or dropped data) until the consumer frees space.
+ * Time is measured with the source set by FIFO_SetTimeSource.
+ */
+typedef struct {
+  uint16_t highWater;   ///< Maximum number of bytes in FIFO
+  uint8_t  full;        ///< Nonzero - FIFO is full since fullStart
+  uint32_t overflows;   ///< Number of pushes which dropped data
+  uint32_t fullTime;    ///< Time spent full
+  uint32_t fullStart;   ///< Time FIFO became full
+  uint32_t histogram[FIFO_HIST_BINS]; ///< Number of non-empty pushes by occupancy (in 1/FIFO_HIST_BINS of length)
+} FIFO_Stats_TypeDef;
+
 /**
  * @brief FIFO structure typedef.
+ *
+ * @details Single producer/single consumer ring buffer. Head is
+ * written only by the producer and tail only by the consumer, so
+ * one side can run in an interrupt without any masking. Indices
+ * run freely and are masked on access - the length has to be
+ * a power of two.
+ *
+ * On overflow the FIFO doesn't report anything - dropped bytes
+ * are counted and can be read with FIFO_GetDropped. With the
+ * FIFO_DROP_OLDEST policy the producer moves the tail too, so the
+ * consumer must not hold data in place - FIFO_GetSpan refuses such
+ * FIFOs and positions from FIFO_Find are only hints.
  */
 typedef struct {
-  uint16_t head;   ///< Head
-  uint16_t tail;   ///< Tail
-  uint8_t* buf;    ///< Pointer to buffer
-  uint16_t len;    ///< Maximum length of FIFO
-  uint16_t count;  ///< Current number of data elements
+  volatile uint16_t head; ///< Head (written only by producer)
+  volatile uint16_t tail; ///< Tail (written only by consumer)
+  uint8_t* buf;           ///< Pointer to buffer
+  uint16_t len;           ///< Maximum length of FIFO (power of two)
+  uint16_t mask;          ///< Mask for wrapping indices
+  FIFO_Policy_TypeDef policy; ///< Overflow policy
+  volatile uint32_t dropped;  ///< Number of bytes dropped on overflow
+  FIFO_Stats_TypeDef stats;   ///< Usage statistics
 } FIFO_TypeDef;
 
-uint8_t FIFO_Add      (FIFO_TypeDef* fifo);
-uint8_t FIFO_Push     (FIFO_TypeDef* fifo, uint8_t c);
-uint8_t FIFO_Pop      (FIFO_TypeDef* fifo, uint8_t* c);
-uint8_t FIFO_IsEmpty  (FIFO_TypeDef* fifo);
+/**
+ * @brief Contiguous part of FIFO buffer.
+ */
+typedef struct {
+  uint8_t* buf; ///< Start of span
+  uint16_t len; ///< Length of span
+} FIFO_Span_TypeDef;
+
+uint8_t   FIFO_Add      (FIFO_TypeDef* fifo);
+uint8_t   FIFO_Push     (FIFO_TypeDef* fifo, uint8_t c);
+uint8_t   FIFO_Pop      (FIFO_TypeDef* fifo, uint8_t* c);
+uint16_t  FIFO_PushBuf  (FIFO_TypeDef* fifo, const uint8_t* buf, uint16_t len);
+uint16_t  FIFO_PopBuf   (FIFO_TypeDef* fifo, uint8_t* buf, uint16_t len);
+uint8_t   FIFO_IsEmpty  (FIFO_TypeDef* fifo);
+uint16_t  FIFO_GetCount (FIFO_TypeDef* fifo);
+uint16_t  FIFO_GetFree  (FIFO_TypeDef* fifo);
+uint16_t  FIFO_PeekBuf  (FIFO_TypeDef* fifo, uint16_t offset, uint8_t* buf, uint16_t len);
+uint16_t  FIFO_GetSpan  (FIFO_TypeDef* fifo, uint8_t** buf);
+void      FIFO_Discard  (FIFO_TypeDef* fifo, uint16_t len);
+uint8_t   FIFO_Find     (FIFO_TypeDef* fifo, uint8_t c, uint16_t* pos);
+uint32_t  FIFO_GetDropped (FIFO_TypeDef* fifo);
+uint8_t*  FIFO_Reserve  (FIFO_TypeDef* fifo, uint16_t len);
+uint16_t  FIFO_Reserve2 (FIFO_TypeDef* fifo, FIFO_Span_TypeDef* span);
+void      FIFO_Commit   (FIFO_TypeDef* fifo, uint16_t len);
+void      FIFO_GetStats (FIFO_TypeDef* fifo, FIFO_Stats_TypeDef* stats);
+void      FIFO_ResetStats (FIFO_TypeDef* fifo);
+void      FIFO_SetTimeSource (uint32_t (*getTime)(void));
 
 /**
  * @}
@@ -0,0 +1,45 @@
+/**
+ * @file:   hrtimer.h
+ * @brief:  High resolution one shot timers
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef HRTIMER_H_
+#define HRTIMER_H_
+
+#include <inttypes.h>
+#include <defer.h>
+
+/**
+ * @defgroup  HRTIMER HRTIMER
+ * @brief     High resolution one shot timers
+ */
+
+/**
+ * @addtogroup HRTIMER
+ * @{
+ */
+
+void      HRTIMER_Init      (void);
+void      HRTIMER_ClockChanged(void);
+uint32_t  HRTIMER_GetTime   (void);
+int8_t    HRTIMER_Schedule  (uint32_t us, DEFER_Callback fun, void* ctx);
+int8_t    HRTIMER_ScheduleAt(uint32_t time, DEFER_Callback fun, void* ctx);
+uint8_t   HRTIMER_Cancel    (int8_t id);
+
+/**
+ * @}
+ */
+
+#endif /* HRTIMER_H_ */
@@ -36,7 +36,29 @@ typedef enum {
   KEY_NONE = 0xff
 } KEY_Id_Typedef;
 
-void KEYS_Init(void);
-uint8_t KEYS_Update(void);
+/**
+ * @brief Keyboard event types.
+ */
+typedef enum {
+  KEYS_PRESS,   //!< KEYS_PRESS   Key pressed (debounced)
+  KEYS_RELEASE, //!< KEYS_RELEASE Key released (debounced)
+  KEYS_REPEAT,  //!< KEYS_REPEAT  Key still held - auto-repeat
+  KEYS_LONG,    //!< KEYS_LONG    Key held for KEYS_LONG_TIME (sent once)
+} KEYS_EventType_TypeDef;
+
+/**
+ * @brief Keyboard event.
+ */
+typedef struct {
+  uint8_t key;    ///< Key number - column * 4 + row
+  uint8_t type;   ///< Event type (KEYS_EventType_TypeDef)
+  uint32_t time;  ///< Time of event in ms
+} KEYS_Event_TypeDef;
+
+void      KEYS_Init     (void);
+void      KEYS_Update   (void);
+uint8_t   KEYS_GetEvent (KEYS_Event_TypeDef* event);
+uint16_t  KEYS_GetState (void);
+uint32_t  KEYS_GetDropped (void);
 
 #endif /* KEYS_H_ */
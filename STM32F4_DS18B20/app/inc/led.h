@@ -26,6 +26,8 @@
 #ifndef LED_H_
 #define LED_H_
 
+#include <inttypes.h>
+
 /**
  * @defgroup  LED LED
  * @brief     Light Emitting Diode control functions.
@@ -62,7 +64,13 @@ typedef enum {
   LED_ON,     //!< LED_ON     Turn on LED
 } LED_State_TypeDef;
 
+/**
+ * @brief Bit of an LED in LED_Update bitmaps.
+ */
+#define LED_MASK(led) (1UL << (led))
+
 void LED_Init         (LED_Number_TypeDef led);
+void LED_Update       (uint32_t set, uint32_t clear, uint32_t toggle);
 void LED_Toggle       (LED_Number_TypeDef led);
 void LED_ChangeState  (LED_Number_TypeDef led, LED_State_TypeDef state);
 
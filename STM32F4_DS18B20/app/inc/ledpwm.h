@@ -0,0 +1,58 @@
+/**
+ * @file:   ledpwm.h
+ * @brief:  LED brightness and pattern engine
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef LEDPWM_H_
+#define LEDPWM_H_
+
+#include <inttypes.h>
+#include <led.h>
+
+/**
+ * @defgroup  LEDPWM LEDPWM
+ * @brief     LED brightness and pattern engine
+ */
+
+/**
+ * @addtogroup LEDPWM
+ * @{
+ */
+
+#define LEDPWM_MAX_LEVEL 255 ///< Full brightness
+
+/**
+ * @brief Pattern step.
+ * @details A step either sets the level right away and holds it,
+ * or fades linearly from the previous level to the new one.
+ */
+typedef struct {
+  uint8_t level;  ///< Brightness at end of step (0 - LEDPWM_MAX_LEVEL)
+  uint8_t fade;   ///< 1 - fade to level during step, 0 - jump to level
+  uint16_t time;  ///< Duration of step in ms
+} LEDPWM_Step_TypeDef;
+
+void LEDPWM_Init      (LED_Number_TypeDef led);
+void LEDPWM_SetLevel  (LED_Number_TypeDef led, uint8_t level);
+void LEDPWM_Blink     (LED_Number_TypeDef led, uint8_t level, uint16_t onTime, uint16_t offTime);
+void LEDPWM_Play      (LED_Number_TypeDef led, const LEDPWM_Step_TypeDef* steps,
+    uint8_t len, uint8_t loop);
+void LEDPWM_ClockChanged(void);
+
+/**
+ * @}
+ */
+
+#endif /* LEDPWM_H_ */
@@ -0,0 +1,72 @@
+/**
+ * @file:   log.h
+ * @brief:  Deferred binary logging
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef LOG_H_
+#define LOG_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  LOG LOG
+ * @brief     Deferred binary logging
+ */
+
+/**
+ * @addtogroup LOG
+ * @{
+ */
+
+#define LOG_MAX_ARGS 6  ///< Maximum number of arguments of a log record
+#define LOG_MAX_STR  32 ///< Maximum length of string copied into a record
+#define LOG_MAX_RECORD (9 + 4 * LOG_MAX_ARGS + LOG_MAX_STR) ///< Maximum record length
+
+/**
+ * @brief Counts macro arguments (0 to LOG_MAX_ARGS).
+ */
+#define LOG_NARGS(args...) LOG_NARGS_(0, ##args, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, n, ...) n
+
+/**
+ * @brief Records a log message.
+ * @details The format string has to be a string literal and the
+ * arguments 32 bit integers (or pointers to constant data). Floating
+ * point and strings in RAM can't be logged (see LOG_STR). Formatting
+ * is done later, by LOG_Flush in text mode or by the host in binary mode.
+ */
+#define LOG(fmt, args...) LOG_Record(fmt, LOG_NARGS(args), ##args)
+
+/**
+ * @brief Records a log message with a copy of a string.
+ * @details The string (at most LOG_MAX_STR characters) is copied
+ * into the record, so it can be in a buffer which changes before
+ * the message is formatted. It has to be the first conversion (%s)
+ * of the format string, the other arguments follow it as in LOG.
+ */
+#define LOG_STR(fmt, str, args...) LOG_RecordStr(fmt, str, LOG_NARGS(args), ##args)
+
+void      LOG_Init        (void);
+void      LOG_Record      (const char* fmt, unsigned int nargs, ...);
+void      LOG_RecordStr   (const char* fmt, const char* str, unsigned int nargs, ...);
+void      LOG_Flush       (void);
+uint16_t  LOG_GetFree     (void);
+uint32_t  LOG_GetDropped  (void);
+
+/**
+ * @}
+ */
+
+#endif /* LOG_H_ */
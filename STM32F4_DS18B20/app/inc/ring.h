@@ -0,0 +1,83 @@
+/**
+ * @file:   ring.h
+ * @brief:  Ring buffer of fixed size records
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef RING_H_
+#define RING_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  RING RING
+ * @brief     Ring buffer of fixed size records
+ */
+
+/**
+ * @addtogroup RING
+ * @{
+ */
+
+/**
+ * @brief Ring structure typedef.
+ *
+ * @details Single producer/single consumer ring of records, same
+ * as FIFO_TypeDef, but indices count whole records. Records are
+ * written and read in place through contiguous spans, so a record
+ * is copied at most once. Define rings with RING_DEFINE.
+ *
+ * Rings written with RING_PushOverwrite keep the newest records
+ * and are read with RING_ReadSince. The head counts all records
+ * ever written, so it is the sequence number of the next record.
+ * Tail then marks the record being written and isn't used for
+ * reading - don't mix both modes on one ring.
+ */
+typedef struct {
+  volatile uint32_t head; ///< Head in records (written only by producer)
+  volatile uint32_t tail; ///< Tail in records (written only by consumer)
+  uint8_t* buf;           ///< Pointer to buffer
+  uint16_t size;          ///< Record size in bytes
+  uint16_t len;           ///< Maximum number of records (power of two)
+  uint16_t mask;          ///< Mask for wrapping indices
+} RING_TypeDef;
+
+/**
+ * @brief Defines a ring with its buffer.
+ * @param name Name of ring structure
+ * @param type Record type
+ * @param count Number of records (power of two)
+ */
+#define RING_DEFINE(name, type, count) \
+  _Static_assert((count) && !((count) & ((count) - 1)), "Ring length not a power of two"); \
+  static type name##Buffer[count]; \
+  static RING_TypeDef name = {0, 0, (uint8_t*)name##Buffer, sizeof(type), (count), (count) - 1}
+
+uint8_t   RING_Add      (RING_TypeDef* ring);
+uint16_t  RING_Reserve  (RING_TypeDef* ring, void** rec, uint16_t max);
+void      RING_Commit   (RING_TypeDef* ring, uint16_t n);
+uint16_t  RING_Peek     (RING_TypeDef* ring, void** rec, uint16_t max);
+void      RING_Consume  (RING_TypeDef* ring, uint16_t n);
+uint8_t   RING_Push     (RING_TypeDef* ring, const void* rec);
+uint8_t   RING_Pop      (RING_TypeDef* ring, void* rec);
+uint16_t  RING_GetCount (RING_TypeDef* ring);
+uint16_t  RING_GetFree  (RING_TypeDef* ring);
+void      RING_PushOverwrite  (RING_TypeDef* ring, const void* rec);
+uint16_t  RING_ReadSince      (RING_TypeDef* ring, uint32_t* seq, void* buf, uint16_t max);
+
+/**
+ * @}
+ */
+
+#endif /* RING_H_ */
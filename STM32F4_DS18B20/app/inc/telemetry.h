@@ -0,0 +1,75 @@
+/**
+ * @file:   telemetry.h
+ * @brief:  Sensor telemetry protocol
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  TELEM TELEM
+ * @brief     Sensor telemetry protocol
+ */
+
+/**
+ * @addtogroup TELEM
+ * @{
+ */
+
+/**
+ * @brief Telemetry output mode.
+ */
+typedef enum {
+  TELEM_MODE_TEXT,    //!< TELEM_MODE_TEXT   Human readable lines
+  TELEM_MODE_BINARY,  //!< TELEM_MODE_BINARY COBS framed binary records
+} TELEM_Mode_TypeDef;
+
+/**
+ * @brief Binary frame types.
+ */
+typedef enum {
+  TELEM_TYPE_SAMPLES = 0x01, //!< TELEM_TYPE_SAMPLES Batch of sensor samples
+  TELEM_TYPE_LOG     = 0x02, //!< TELEM_TYPE_LOG     Deferred log records
+  TELEM_TYPE_HISTORY = 0x03, //!< TELEM_TYPE_HISTORY Recent samples of a sensor
+} TELEM_Type_TypeDef;
+
+#define TELEM_MAX_PAYLOAD 128 ///< Maximum payload length of binary frame
+#define TELEM_MAX_SENSORS 4   ///< Number of sensors with sample history
+
+/**
+ * @brief Sensor sample record (as sent in binary frames).
+ */
+typedef struct {
+  uint32_t time;    ///< System time of sample in ms
+  int16_t  temp;    ///< Temperature in 1/16 degrees Celsius
+  uint8_t  sensor;  ///< Sensor number
+} __attribute((packed)) TELEM_Sample_TypeDef;
+
+void    TELEM_Init      (TELEM_Mode_TypeDef mode);
+void    TELEM_SetMode   (TELEM_Mode_TypeDef mode);
+TELEM_Mode_TypeDef TELEM_GetMode(void);
+void    TELEM_AddSample (uint8_t sensor, int16_t temp);
+void    TELEM_Flush     (void);
+void    TELEM_Update    (void);
+uint8_t TELEM_SendFrame (uint8_t type, const uint8_t* payload, uint16_t len);
+uint32_t TELEM_SendHistory(uint8_t sensor, uint32_t since);
+
+/**
+ * @}
+ */
+
+#endif /* TELEMETRY_H_ */
@@ -22,6 +22,7 @@
 #define TIMERS_H_
 
 #include <inttypes.h>
+#include <defer.h>
 
 /**
  * @defgroup  TIMER TIMER
@@ -34,11 +35,19 @@
  */
 
 void      TIMER_Init              (uint32_t freq);
+void      TIMER_ClockChanged      (void);
 void      TIMER_DelayUS           (uint32_t us);
 void      TIMER_Delay             (uint32_t ms);
+void      TIMER_SleepUntil        (uint32_t time);
+void      TIMER_Idle              (void);
+uint8_t   TIMER_CallAfter         (uint32_t ms, DEFER_Callback fun, void* ctx);
 uint8_t   TIMER_DelayTimer        (uint32_t ms, uint32_t startTime);
 int8_t    TIMER_AddSoftTimer      (uint32_t maxVal, void (*fun)(void));
+int8_t    TIMER_AddSoftTimerDeferred(uint32_t maxVal, DEFER_Callback fun, void* ctx);
 void      TIMER_StartSoftTimer    (uint8_t id);
+void      TIMER_SetSoftTimerDeadline(uint8_t id, uint32_t us);
+void      TIMER_ResetStats        (uint8_t id);
+void      TIMER_PrintStats        (void);
 void      TIMER_SoftTimersUpdate  (void);
 uint32_t  TIMER_GetTime           (void);
 /**
@@ -21,34 +21,77 @@
 #include <math.h>
 
 #include <timers.h>
+#include <hrtimer.h>
+#include <defer.h>
 #include <led.h>
+#include <ledpwm.h>
 #include <comm.h>
 #include <keys.h>
 #include <onewire.h>
 #include <ds18b20.h>
+#include <telemetry.h>
+#include <log.h>
+#include <cmd.h>
+#include <fifo.h>
 
 #define SYSTICK_FREQ 1000 ///< Frequency of the SysTick set at 1kHz.
 #define COMM_BAUD_RATE 115200UL ///< Baud rate for communication with PC
+#define DEFER_MAX_PER_PASS 4 ///< Maximum number of deferred callbacks run in one main loop pass
+#define BAUD_TOLERANCE 15000 ///< Maximum baud rate error in ppm
+#define BAUD_CONFIRM_TIME 2000 ///< Time for host to confirm new baud rate in ms
 
 void softTimerCallback(void);
+void ledCommand(uint8_t argc, CMD_Arg_TypeDef* argv);
+void timersCommand(uint8_t argc, CMD_Arg_TypeDef* argv);
+void telemCommand(uint8_t argc, CMD_Arg_TypeDef* argv);
+void commCommand(uint8_t argc, CMD_Arg_TypeDef* argv);
+void baudCommand(uint8_t argc, CMD_Arg_TypeDef* argv);
+void historyCommand(uint8_t argc, CMD_Arg_TypeDef* argv);
+void baudRevertCallback(void* ctx);
+void keyEvent(KEYS_Event_TypeDef* event);
+
+/**
+ * @brief LED2 breathing pattern.
+ */
+static const LEDPWM_Step_TypeDef breathe[] = {
+    {LEDPWM_MAX_LEVEL, 1, 1000}, // fade in
+    {0, 1, 1000},                // fade out
+    {0, 0, 500},                 // stay off
+};
+
+static uint32_t baudPrevious; ///< Baud rate to revert to if host doesn't confirm change
+static uint8_t baudPending;   ///< Nonzero - baud rate change waits for confirmation
+static uint32_t baudChange;   ///< Number of baud rate changes (matches revert callback to its change)
 
 #define DEBUG
 
 #ifdef DEBUG
-#define print(str, args...) printf(""str"%s",##args,"")
-#define println(str, args...) printf("MAIN--> "str"%s",##args,"\r\n")
+#define print(str, args...) LOG("MAIN--> "str"\r", ##args)
+#define println(str, args...) LOG("MAIN--> "str"\r\n", ##args)
+#define printlnStr(str, s, args...) LOG_STR("MAIN--> "str"\r\n", s, ##args) ///< Copies string for first conversion
 #else
 #define print(str, args...) (void)0
 #define println(str, args...) (void)0
+#define printlnStr(str, s, args...) (void)0
 #endif
 
+/**
+ * @brief Reply in baud rate handshake.
+ * @details Written to TX buffer right away - it has to go out
+ * before the rate is switched.
+ */
+#define reply(str, args...) printf("MAIN--> "str"\r\n", ##args)
+
 
 int main(void) {
 	
+  LOG_Init(); // initialize deferred logging
   COMM_Init(COMM_BAUD_RATE); // initialize communication with PC
   println("Starting program"); // Print a string to terminal
 
 	TIMER_Init(SYSTICK_FREQ); // Initialize timer
+	FIFO_SetTimeSource(TIMER_GetTime); // buffer statistics in ms
+	HRTIMER_Init(); // Initialize microsecond callbacks
 
 	// Add a soft timer with callback running every 1000ms
 	int8_t timerID = TIMER_AddSoftTimer(1000, softTimerCallback);
@@ -56,45 +99,50 @@ int main(void) {
 
 	LED_Init(LED0); // Add an LED
 	LED_Init(LED1); // Add an LED
-	LED_Init(LED2); // Add an LED
-	LED_Init(LED3); // Add an LED
+	LEDPWM_Init(LED2); // LEDs driven by timer patterns
+	LEDPWM_Init(LED3);
+	LEDPWM_Play(LED2, breathe, sizeof(breathe) / sizeof(breathe[0]), 1);
+	LEDPWM_Blink(LED3, LEDPWM_MAX_LEVEL, 1000, 1000);
 	LED_Init(LED5); // Add nonexising LED for test
 	LED_ChangeState(LED5, LED_ON);
 
 	KEYS_Init(); // Initialize matrix keyboard
 
-  uint8_t buf[255]; // buffer for receiving commands from PC
-  uint8_t len;      // length of command
+  uint8_t* frame; // command frame from PC (parsed in the RX buffer)
+  uint16_t len;   // length of command
+  KEYS_Event_TypeDef event; // keyboard event
 
-  // test another way of measuring time delays
-  uint32_t softTimer = TIMER_GetTime(); // get start time for delay
+  // commands from PC
+  CMD_Register("LED0", "s", ledCommand);        // :LED0 ON|OFF
+  CMD_Register("TIMERS", "", timersCommand);    // dump soft timer timing statistics
+  CMD_Register("TELEM", "s", telemCommand);     // :TELEM BIN|TEXT
+  CMD_Register("COMM", "s", commCommand);       // :COMM STATS|RESET
+  CMD_Register("BAUD", "|i", baudCommand);      // :BAUD rate, confirmed with :BAUD
+  CMD_Register("HISTORY", "i|i", historyCommand); // :HISTORY sensor [since]
 
   ONEWIRE_Init(); // initialize ONEWIRE bus
   DS18B20_Init(); // initialize DS18B20 on the bus
 
-	while (1) {
+  TELEM_Init(TELEM_MODE_TEXT); // sensor samples as text by default
 
-	  // test delay method
-	  if (TIMER_DelayTimer(1000, softTimer)) {
-	    LED_Toggle(LED3);
-	    softTimer = TIMER_GetTime(); // get start time for delay
-	  }
+	while (1) {
 
 	  // check for new frames from PC
-	  if (!COMM_GetFrame(buf, &len)) {
-	    println("Got frame of length %d: %s", (int)len, (char*)buf);
-
-	    // control LED0 from terminal
-	    if (!strcmp((char*)buf, ":LED0 ON")) {
-	      LED_ChangeState(LED0, LED_ON);
-	    }
-	    if (!strcmp((char*)buf, ":LED0 OFF")) {
-	      LED_ChangeState(LED0, LED_OFF);
-	    }
+	  if (!COMM_GetFrameRef(&frame, &len)) {
+	    printlnStr("Got frame %s of length %d", (char*)frame, (int)len);
+	    CMD_Execute((char*)frame);
+	    COMM_ReleaseFrame();
 	  }
 
 		TIMER_SoftTimersUpdate(); // run timers
+		DEFER_Run(DEFER_MAX_PER_PASS); // run deferred callbacks
+		TELEM_Update(); // send waiting samples
+		LOG_Flush(); // send recorded log messages
 		KEYS_Update(); // run keyboard
+
+		while (!KEYS_GetEvent(&event)) {
+		  keyEvent(&event);
+		}
 	}
 }
 
@@ -104,7 +152,6 @@ int main(void) {
 void softTimerCallback(void) {
 
   static uint8_t counter;
-  double temp;
 
   // get temperature every 2 seconds
   switch (counter % 2) {
@@ -113,8 +160,7 @@ void softTimerCallback(void) {
     break;
 
   case 1:
-    temp = DS18B20_ReadTemp();
-    println("Temperature = %.2f", temp);
+    TELEM_AddSample(0, DS18B20_ReadTempRaw());
     break;
 
   }
@@ -124,3 +170,169 @@ void softTimerCallback(void) {
   LED_Toggle(LED1); // Toggle LED
 
 }
+/**
+ * @brief Command controlling LED0.
+ * @param argc Number of arguments
+ * @param argv ON or OFF
+ */
+void ledCommand(uint8_t argc, CMD_Arg_TypeDef* argv) {
+
+  if (!strcmp(argv[0].s, "ON")) {
+    LED_ChangeState(LED0, LED_ON);
+  } else if (!strcmp(argv[0].s, "OFF")) {
+    LED_ChangeState(LED0, LED_OFF);
+  }
+}
+/**
+ * @brief Command dumping soft timer timing statistics.
+ * @param argc Number of arguments
+ * @param argv No arguments
+ */
+void timersCommand(uint8_t argc, CMD_Arg_TypeDef* argv) {
+
+  TIMER_PrintStats();
+}
+/**
+ * @brief Command selecting telemetry format.
+ * @param argc Number of arguments
+ * @param argv BIN or TEXT
+ */
+void telemCommand(uint8_t argc, CMD_Arg_TypeDef* argv) {
+
+  if (!strcmp(argv[0].s, "BIN")) {
+    TELEM_SetMode(TELEM_MODE_BINARY);
+  } else if (!strcmp(argv[0].s, "TEXT")) {
+    TELEM_SetMode(TELEM_MODE_TEXT);
+  }
+}
+/**
+ * @brief Prints buffer usage statistics.
+ * @param name Buffer name
+ * @param stats Statistics
+ */
+static void printBufferStats(const char* name, FIFO_Stats_TypeDef* stats) {
+
+  uint8_t i;
+
+  println("%s high water %u, overflows %u, full for %u ms", name,
+      (unsigned int)stats->highWater, (unsigned int)stats->overflows,
+      (unsigned int)stats->fullTime);
+
+  // FIFO_HIST_BINS is a multiple of 4 - four bins per message
+  for (i = 0; i < FIFO_HIST_BINS; i += 4) {
+    println("%s occupancy [%u] %u %u %u %u", name, (unsigned int)i,
+        (unsigned int)stats->histogram[i], (unsigned int)stats->histogram[i + 1],
+        (unsigned int)stats->histogram[i + 2], (unsigned int)stats->histogram[i + 3]);
+  }
+}
+/**
+ * @brief Command reporting communication statistics.
+ * @param argc Number of arguments
+ * @param argv STATS or RESET
+ */
+void commCommand(uint8_t argc, CMD_Arg_TypeDef* argv) {
+
+  COMM_Stats_TypeDef stats;
+  FIFO_Stats_TypeDef rx;
+  FIFO_Stats_TypeDef tx;
+
+  if (!strcmp(argv[0].s, "STATS")) {
+    COMM_GetStats(&stats);
+    println("TX dropped %u, RX dropped %u, frames dropped %u, TX timeouts %u, log dropped %u",
+        (unsigned int)stats.txDropped, (unsigned int)stats.rxDropped,
+        (unsigned int)stats.framesDropped, (unsigned int)stats.txTimeouts,
+        (unsigned int)LOG_GetDropped());
+    COMM_GetBufferStats(&rx, &tx);
+    printBufferStats("RX", &rx);
+    printBufferStats("TX", &tx);
+  } else if (!strcmp(argv[0].s, "RESET")) {
+    COMM_ResetStats();
+  }
+}
+/**
+ * @brief Command changing console baud rate.
+ * @details Handshake with host:
+ * - host sends :BAUD rate
+ * - device reports achieved rate and error, and switches if the
+ *   error is within tolerance
+ * - host switches and sends :BAUD (no arguments) with new rate
+ * - if it doesn't come in time, device goes back to old rate
+ * @param argc Number of arguments
+ * @param argv New baud rate (none - confirmation)
+ */
+void baudCommand(uint8_t argc, CMD_Arg_TypeDef* argv) {
+
+  int32_t error;
+
+  if (argc == 0) {
+    if (baudPending) {
+      baudPending = 0;
+      reply("BAUD %u confirmed", (unsigned int)COMM_GetBaud());
+    } else {
+      reply("BAUD %u", (unsigned int)COMM_GetBaud());
+    }
+    return;
+  }
+
+  if (argv[0].i <= 0 || baudPending) {
+    reply("BAUD rejected");
+    return;
+  }
+
+  uint32_t achieved = COMM_CheckBaud(argv[0].i, &error);
+
+  reply("BAUD %d achieved %u error %d ppm", (int)argv[0].i,
+      (unsigned int)achieved, (int)error);
+
+  if (error > BAUD_TOLERANCE || error < -BAUD_TOLERANCE) {
+    reply("BAUD rejected");
+    return;
+  }
+
+  if (TIMER_CallAfter(BAUD_CONFIRM_TIME, baudRevertCallback,
+      (void*)(uintptr_t)(baudChange + 1))) {
+    reply("BAUD rejected");
+    return;
+  }
+
+  baudPrevious = COMM_GetBaud();
+  baudPending = 1;
+  baudChange++;
+  COMM_SetBaud(argv[0].i); // reply is sent with old rate
+}
+/**
+ * @brief Reverts baud rate change not confirmed by host.
+ * @details Callbacks of earlier (confirmed) changes are ignored.
+ * @param ctx Number of the change the callback was scheduled for
+ */
+void baudRevertCallback(void* ctx) {
+
+  if (baudPending && (uint32_t)(uintptr_t)ctx == baudChange) {
+    baudPending = 0;
+    COMM_SetBaud(baudPrevious);
+    reply("BAUD %u reverted", (unsigned int)baudPrevious);
+  }
+}
+/**
+ * @brief Command sending recent samples of a sensor.
+ * @param argc Number of arguments
+ * @param argv Sensor number and optional sequence number of first sample
+ */
+void historyCommand(uint8_t argc, CMD_Arg_TypeDef* argv) {
+
+  uint32_t since = (argc > 1) ? argv[1].i : 0;
+
+  since = TELEM_SendHistory(argv[0].i, since);
+
+  println("HISTORY next %u", (unsigned int)since);
+}
+/**
+ * @brief Handles keyboard events.
+ * @param event Keyboard event
+ */
+void keyEvent(KEYS_Event_TypeDef* event) {
+
+  static const char* names[] = {"pressed", "released", "repeated", "held"};
+
+  println("Key %d %s", event->key, names[event->type]);
+}
@@ -0,0 +1,283 @@
+/**
+ * @file:   cmd.c
+ * @brief:  Command dispatcher
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @details Commands are lines like ":LED0 ON" - a colon, the command
+ * name and arguments separated by spaces. Names are looked up in an
+ * open addressing hash table, so dispatch costs one hash of the name
+ * and (almost always) one string compare, however many commands are
+ * registered.
+ *
+ * Each command declares its argument types when registered, e.g.
+ * "si" for a word followed by an integer. Arguments after a '|' are
+ * optional. The line is tokenized in place and the arguments are
+ * converted before the handler is called.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <cmd.h>
+#include <log.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef DEBUG
+  #define DEBUG
+#endif
+
+#ifdef DEBUG
+  #define print(str, args...) LOG("CMD--> "str"\r", ##args)
+  #define println(str, args...) LOG("CMD--> "str"\r\n", ##args)
+  #define printlnStr(str, s, args...) LOG_STR("CMD--> "str"\r\n", s, ##args) ///< Copies string for first conversion
+#else
+  #define print(str, args...) (void)0
+  #define println(str, args...) (void)0
+  #define printlnStr(str, s, args...) (void)0
+#endif
+
+/**
+ * @addtogroup CMD
+ * @{
+ */
+
+#define CMD_TABLE_LEN   64                  ///< Hash table length (power of two)
+#define CMD_TABLE_MASK  (CMD_TABLE_LEN - 1) ///< Mask for wrapping hash table index
+#define CMD_PREFIX      ':'                 ///< Command prefix character
+#define CMD_OPTIONAL    '|'                 ///< Optional arguments separator in argument types
+
+/**
+ * @brief Token delimiters - line endings are whitespace too.
+ */
+#define CMD_IS_DELIMITER(c) ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+
+/**
+ * @brief Registered command.
+ */
+typedef struct {
+  const char* name;     ///< Command name (NULL - free entry)
+  const char* args;     ///< Argument types
+  uint32_t hash;        ///< Hash of name
+  CMD_Handler handler;  ///< Handler function
+} CMD_TypeDef;
+
+static CMD_TypeDef commands[CMD_TABLE_LEN]; ///< Hash table of commands
+
+/**
+ * @brief Calculates FNV-1a hash of a string.
+ * @param str String
+ * @return Hash value
+ */
+static uint32_t CMD_Hash(const char* str) {
+
+  uint32_t hash = 2166136261u;
+
+  while (*str) {
+    hash ^= (uint8_t)*str++;
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+/**
+ * @brief Finds hash table entry of a command.
+ * @param name Command name
+ * @param hash Hash of name
+ * @return Entry of command or free entry where it should go
+ * (NULL if table is full)
+ */
+static CMD_TypeDef* CMD_Find(const char* name, uint32_t hash) {
+
+  uint8_t i;
+  uint32_t idx = hash;
+
+  // linear probing
+  for (i = 0; i < CMD_TABLE_LEN; i++, idx++) {
+
+    CMD_TypeDef* cmd = &commands[idx & CMD_TABLE_MASK];
+
+    if (cmd->name == NULL) {
+      return cmd;
+    }
+    if (cmd->hash == hash && !strcmp(cmd->name, name)) {
+      return cmd;
+    }
+  }
+
+  return NULL;
+}
+/**
+ * @brief Checks argument specification.
+ * @param args Argument types
+ * @retval 0 Specification valid
+ * @retval 1 Error: unknown type, more than one '|' or
+ * more than CMD_MAX_ARGS arguments
+ */
+static uint8_t CMD_CheckArgs(const char* args) {
+
+  uint8_t count = 0;
+  uint8_t optional = 0;
+
+  for (; *args; args++) {
+    if (*args == CMD_OPTIONAL) {
+      if (optional++) {
+        return 1;
+      }
+    } else if (*args == 'i' || *args == 's') {
+      if (++count > CMD_MAX_ARGS) {
+        return 1;
+      }
+    } else {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+/**
+ * @brief Registers a command.
+ * @param name Command name (without prefix, has to be constant - it
+ * is kept and logged by address)
+ * @param args Argument types: 'i' integer, 's' word, arguments
+ * after '|' are optional (e.g. "s|i")
+ * @param handler Handler function
+ * @retval 0 Command registered
+ * @retval 1 Error: table full or invalid argument types
+ */
+uint8_t CMD_Register(const char* name, const char* args, CMD_Handler handler) {
+
+  uint32_t hash = CMD_Hash(name);
+  CMD_TypeDef* cmd = CMD_Find(name, hash);
+
+  if (cmd == NULL || CMD_CheckArgs(args)) {
+    println("Can't register command %s", name);
+    return 1;
+  }
+
+  cmd->hash     = hash;
+  cmd->args     = args;
+  cmd->handler  = handler;
+  cmd->name     = name;
+
+  return 0;
+}
+/**
+ * @brief Splits off next whitespace separated token.
+ * @param str Pointer to current position in line (updated)
+ * @return Token (NULL terminated) or NULL if no more tokens
+ */
+static char* CMD_NextToken(char** str) {
+
+  char* p = *str;
+
+  while (*p && CMD_IS_DELIMITER(*p)) {
+    p++;
+  }
+
+  if (*p == 0) {
+    *str = p;
+    return NULL;
+  }
+
+  char* token = p;
+
+  while (*p && !CMD_IS_DELIMITER(*p)) {
+    p++;
+  }
+
+  if (*p) {
+    *p++ = 0;
+  }
+
+  *str = p;
+
+  return token;
+}
+/**
+ * @brief Parses and executes a command line.
+ * @details The line is modified (tokenized in place).
+ * @param line NULL terminated command line
+ * @return Result of execution
+ */
+CMD_Result_TypeDef CMD_Execute(char* line) {
+
+  CMD_Arg_TypeDef argv[CMD_MAX_ARGS];
+  uint8_t argc = 0;
+  char* token;
+  char* end;
+
+  char* name = CMD_NextToken(&line);
+
+  if (name == NULL) {
+    return CMD_EMPTY;
+  }
+
+  if (*name == CMD_PREFIX) {
+    name++;
+  }
+
+  CMD_TypeDef* cmd = CMD_Find(name, CMD_Hash(name));
+
+  if (cmd == NULL || cmd->name == NULL) {
+    printlnStr("Unknown command %s", name); // name is in the frame buffer
+    return CMD_UNKNOWN;
+  }
+
+  const char* type = cmd->args;
+  uint8_t optional = 0;
+
+  while ((token = CMD_NextToken(&line)) != NULL) {
+
+    if (*type == CMD_OPTIONAL) {
+      optional = 1;
+      type++;
+    }
+
+    if (argc == CMD_MAX_ARGS) {
+      println("%s: too many arguments", cmd->name);
+      return CMD_BAD_ARGS;
+    }
+
+    switch (*type) {
+    case 'i':
+      argv[argc].i = strtol(token, &end, 0);
+      if (*end) {
+        println("%s: argument %d not an integer", cmd->name, argc + 1);
+        return CMD_BAD_ARGS;
+      }
+      break;
+    case 's':
+      argv[argc].s = token;
+      break;
+    default: // no more arguments expected
+      println("%s: too many arguments", cmd->name);
+      return CMD_BAD_ARGS;
+    }
+
+    argc++;
+    type++;
+  }
+
+  // missing arguments are fine only if optional
+  if (*type && *type != CMD_OPTIONAL && !optional) {
+    println("%s: missing arguments", cmd->name);
+    return CMD_BAD_ARGS;
+  }
+
+  cmd->handler(argc, argv);
+
+  return CMD_OK;
+}
+
+/**
+ * @}
+ */
@@ -17,17 +17,21 @@
 
 #include <comm.h>
 #include <fifo.h>
+#include <hrtimer.h>
+#include <timers.h>
 // HAL
-#include <uart2.h>
+#include <uart.h>
 #include <stdio.h>
+#include <log.h>
+#include <string.h>
 
 #ifndef DEBUG
   #define DEBUG
 #endif
 
 #ifdef DEBUG
-  #define print(str, args...) printf("COMM--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("COMM--> "str"%s",##args,"\r\n")
+  #define print(str, args...) LOG("COMM--> "str"\r", ##args)
+  #define println(str, args...) LOG("COMM--> "str"\r\n", ##args)
 #else
   #define print(str, args...) (void)0
   #define println(str, args...) (void)0
@@ -43,151 +47,639 @@
  * @{
  */
 
-#define COMM_BUF_LEN     2048    ///< COMM buffer lengths
+#define COMM_BUF_LEN     2048    ///< Console buffer lengths (power of two)
 #define COMM_TERMINATOR '\r'     ///< COMM frame terminator character
 
-static uint8_t rxBuffer[COMM_BUF_LEN]; ///< Buffer for received data.
-static uint8_t txBuffer[COMM_BUF_LEN]; ///< Buffer for transmitted data.
+static uint8_t rxBuffer[COMM_BUF_LEN]; ///< Console buffer for received data.
+static uint8_t txBuffer[COMM_BUF_LEN]; ///< Console buffer for transmitted data.
 
-static FIFO_TypeDef rxFifo; ///< RX FIFO
-static FIFO_TypeDef txFifo; ///< TX FIFO
+/*
+ * Both FIFOs of a channel have a single producer and a single consumer:
+ * RX is filled by the receive interrupts and emptied by the main loop,
+ * TX is filled by the main loop and emptied by the transmit interrupt.
+ * Writes should therefore not be done from interrupts.
+ */
+static COMM_Channel_TypeDef console; ///< Console channel (printf, commands)
 
-static uint8_t gotFrame;  ///< Nonzero signals a new frame (number of received frames)
+static COMM_Channel_TypeDef* channels[COMM_HAL_PORTS]; ///< Channels on ports
 
-uint8_t COMM_TxCallback(uint8_t* c);
-void    COMM_RxCallback(uint8_t c);
+static uint16_t COMM_TxCallback(void* ctx, uint16_t sent, uint8_t** buf);
+static void     COMM_RxCallback(void* ctx, uint8_t* buf, uint16_t len);
 
 /**
- * @brief Initialize communication terminal interface.
- *
+ * @brief Initialize a communication channel.
+ * @details Buffer lengths have to be powers of two. The lower
+ * layer services every port with its own interrupts, so channels
+ * don't block each other.
+ * @param ch Channel
+ * @param port Lower layer port
  * @param baud Required baud rate
+ * @param rxBuf Buffer for received data
+ * @param rxLen Length of rxBuf
+ * @param txBuf Buffer for transmitted data
+ * @param txLen Length of txBuf
+ * @retval 0 Channel initialized
+ * @retval 1 Error: wrong port, port already used or wrong buffer length
  */
-void COMM_Init(uint32_t baud) {
+uint8_t COMM_ChannelInit(COMM_Channel_TypeDef* ch, uint8_t port, uint32_t baud,
+    uint8_t* rxBuf, uint16_t rxLen, uint8_t* txBuf, uint16_t txLen) {
+
+  if (port >= COMM_HAL_PORTS || channels[port]) {
+    println("Port %d not available", port);
+    return 1;
+  }
+
+  memset(ch, 0, sizeof(COMM_Channel_TypeDef));
+  ch->port = port;
+
+  // Initialize RX FIFO
+  ch->rxFifo.buf = rxBuf;
+  ch->rxFifo.len = rxLen;
+
+  // Initialize TX FIFO
+  ch->txFifo.buf = txBuf;
+  ch->txFifo.len = txLen;
+
+  if (FIFO_Add(&ch->rxFifo) || FIFO_Add(&ch->txFifo)) {
+    return 1;
+  }
+
+  channels[port] = ch;
 
   // pass baud rate
   // callback for received data and callback for
   // transmitted data
-  COMM_HAL_Init(baud, COMM_RxCallback, COMM_TxCallback);
+  COMM_HAL_Init(port, baud, ch, COMM_RxCallback, COMM_TxCallback);
 
-  // Initialize RX FIFO
-  rxFifo.buf = rxBuffer;
-  rxFifo.len = COMM_BUF_LEN;
-  FIFO_Add(&rxFifo);
+  return 0;
+}
+/**
+ * @brief Initialize communication terminal interface.
+ *
+ * @param baud Required baud rate
+ */
+void COMM_Init(uint32_t baud) {
 
-  // Initialize TX FIFO
-  txFifo.buf = txBuffer;
-  txFifo.len = COMM_BUF_LEN;
-  FIFO_Add(&txFifo);
+  COMM_ChannelInit(&console, COMM_HAL_CONSOLE, baud,
+      rxBuffer, COMM_BUF_LEN, txBuffer, COMM_BUF_LEN);
+}
+
+/**
+ * @brief Update baud rate settings after clock change.
+ * @details Call this function every time the APB
+ * clocks are changed, so that the baud rates are kept.
+ */
+void COMM_ClockChanged(void) {
+
+  uint8_t i;
 
+  for (i = 0; i < COMM_HAL_PORTS; i++) {
+    if (channels[i]) {
+      COMM_HAL_UpdateClock(i);
+    }
+  }
 }
+/**
+ * @brief Checks baud rate which would be achieved on a channel.
+ * @details Use it to check if the rate is within tolerance
+ * before switching.
+ * @param ch Channel
+ * @param baud Required baud rate
+ * @param error Relative error of achieved baud rate in ppm
+ * (INT32_MAX for rate 0)
+ * @return Achieved baud rate (0 - rate 0 rejected)
+ */
+uint32_t COMM_ChannelCheckBaud(COMM_Channel_TypeDef* ch, uint32_t baud, int32_t* error) {
+
+  if (baud == 0) { // out of any tolerance
+    *error = INT32_MAX;
+    return 0;
+  }
 
+  uint32_t achieved = COMM_HAL_CalcBaud(ch->port, baud);
+
+  *error = ((int64_t)achieved - baud) * 1000000 / baud;
+
+  return achieved;
+}
 /**
- * @brief Send a char to USART2.
- * @details This function can be called in stubs.c _write
- * function in order for printf to work
+ * @brief Changes baud rate of a channel.
+ * @details Data waiting in TX buffer is sent first with the
+ * old baud rate.
+ * @param ch Channel
+ * @param baud Required baud rate
+ * @return Achieved baud rate (rate 0 is rejected - current rate)
+ * @warning Blocking function! Waits until TX buffer is empty.
+ */
+uint32_t COMM_ChannelSetBaud(COMM_Channel_TypeDef* ch, uint32_t baud) {
+
+  if (baud == 0) {
+    println("Baud rate 0 rejected");
+    return COMM_HAL_GetBaud(ch->port);
+  }
+
+  while (!FIFO_IsEmpty(&ch->txFifo)) { // wait until everything is sent
+    TIMER_Idle();
+  }
+
+  return COMM_HAL_SetBaud(ch->port, baud);
+}
+/**
+ * @brief Get baud rate of a channel.
+ * @param ch Channel
+ * @return Achieved baud rate
+ */
+uint32_t COMM_ChannelGetBaud(COMM_Channel_TypeDef* ch) {
+
+  return COMM_HAL_GetBaud(ch->port);
+}
+/**
+ * @brief Send a block of data to a channel.
+ * @details Data is copied into the TX buffer with at most two
+ * memcpy calls and the transmitter is started once.
  *
- * @param c Char to send.
+ * @param ch Channel
+ * @param buf Data to send.
+ * @param len Number of bytes.
+ * @return Number of bytes accepted (less than len if TX buffer got full,
+ * see COMM_ChannelSetTxPolicy)
  */
-void COMM_Putc(uint8_t c) {
-  // disable IRQ so it doesn't screw up FIFO count - leads to errors in transmission
-  COMM_HAL_IrqDisable;
+uint16_t COMM_ChannelWrite(COMM_Channel_TypeDef* ch, const uint8_t* buf, uint16_t len) {
+
+  uint16_t sent = 0;
+  uint16_t free;
+  uint32_t start = HRTIMER_GetTime();
+
+  if (ch->txPolicy == COMM_TX_BLOCK && ch->txStalled) {
+    // don't wait again if nothing was sent since last timeout
+    ch->txStalled = (FIFO_GetFree(&ch->txFifo) == 0);
+  }
 
-  FIFO_Push(&txFifo,c); // Put data in TX buffer
-  COMM_HAL_TxEnable();  // Enable low level transmitter
+  if (ch->txPolicy == COMM_TX_BLOCK && !ch->txStalled) {
 
-  // enable IRQ again
-  COMM_HAL_IrqEnable;
+    // put data in TX buffer as space is freed by transmitter
+    while (1) {
+
+      free = FIFO_GetFree(&ch->txFifo);
+      if (free > len - sent) {
+        free = len - sent;
+      }
+
+      sent += FIFO_PushBuf(&ch->txFifo, buf + sent, free);
+      COMM_HAL_TxEnable(ch->port);  // Enable low level transmitter
+
+      if (sent == len) {
+        return len;
+      }
+
+      if (HRTIMER_GetTime() - start >= ch->txTimeout) {
+        ch->txStalled = 1;
+        ch->txTimeouts++;
+        break;
+      }
+    }
+  }
+
+  // what doesn't fit is dropped
+  sent += FIFO_PushBuf(&ch->txFifo, buf + sent, len - sent); // Put data in TX buffer
+  COMM_HAL_TxEnable(ch->port);  // Enable low level transmitter
+
+  return sent;
+}
+/**
+ * @brief Reserve contiguous space in TX buffer of a channel.
+ * @details Lets encoders write straight into transmit memory.
+ * Publish the data with COMM_ChannelTxCommit. Reserving doesn't
+ * wait for space, whatever the TX policy.
+ * @param ch Channel
+ * @param len Number of bytes needed
+ * @return Start of reserved space (NULL - not enough contiguous space)
+ */
+uint8_t* COMM_ChannelTxReserve(COMM_Channel_TypeDef* ch, uint16_t len) {
+
+  return FIFO_Reserve(&ch->txFifo, len);
+}
+/**
+ * @brief Reserve all free space in TX buffer of a channel.
+ * @details Space wrapping around the end of buffer is returned
+ * as two spans. Publish the data with COMM_ChannelTxCommit.
+ * @param ch Channel
+ * @param span Two spans of free space
+ * @return Number of free bytes in both spans
+ */
+uint16_t COMM_ChannelTxReserve2(COMM_Channel_TypeDef* ch, FIFO_Span_TypeDef* span) {
+
+  return FIFO_Reserve2(&ch->txFifo, span);
+}
+/**
+ * @brief Send data written into reserved TX space.
+ * @param ch Channel
+ * @param len Number of bytes written (not more than reserved)
+ */
+void COMM_ChannelTxCommit(COMM_Channel_TypeDef* ch, uint16_t len) {
+
+  FIFO_Commit(&ch->txFifo, len);
+  COMM_HAL_TxEnable(ch->port);  // Enable low level transmitter
+}
+/**
+ * @brief Sets policy for data which doesn't fit into TX buffer.
+ * @details With COMM_TX_BLOCK writes wait for the transmitter, but
+ * no longer than the timeout. If a write times out, next writes
+ * don't wait until some data is sent. Blocking needs HRTIMER running
+ * and writes from interrupts, which block the TX interrupt, will
+ * always wait for the whole timeout. The TX FIFO itself always
+ * drops the newest data (FIFO_DROP_NEWEST), because DMA sends its
+ * spans in place.
+ * @param ch Channel
+ * @param policy Overflow policy
+ * @param timeout Maximum waiting time in ms (for COMM_TX_BLOCK)
+ */
+void COMM_ChannelSetTxPolicy(COMM_Channel_TypeDef* ch, COMM_TxPolicy_TypeDef policy, uint32_t timeout) {
+
+  ch->txTimeout = timeout * 1000;
+  ch->txStalled = 0;
+  ch->txPolicy  = policy;
 }
 /**
- * @brief Get a char from USART2
+ * @brief Get free space in transmit buffer.
+ * @param ch Channel
+ * @return Number of chars which can be sent without loss
+ */
+uint16_t COMM_ChannelGetTxFree(COMM_Channel_TypeDef* ch) {
+
+  return FIFO_GetFree(&ch->txFifo);
+}
+/**
+ * @brief Get a char from a channel
+ * @param ch Channel
  * @return Received char.
  * @warning Blocking function! Waits until char is received.
  */
-uint8_t COMM_Getc(void) {
+uint8_t COMM_ChannelGetc(COMM_Channel_TypeDef* ch) {
 
   uint8_t c;
 
-  while (FIFO_IsEmpty(&rxFifo) == 1); // wait until buffer is not empty
+  while (FIFO_IsEmpty(&ch->rxFifo) == 1); // wait until buffer is not empty
   // buffer not empty => char was received
 
-//  USART_ITConfig(USART2, USART_IT_RXNE, DISABLE); // disable RX interrupt
-
-  FIFO_Pop(&rxFifo,&c); // Get data from RX buffer
-
-//  USART_ITConfig(USART2, USART_IT_RXNE, ENABLE); // enable RX interrupt
+  FIFO_Pop(&ch->rxFifo, &c); // Get data from RX buffer
 
   return c;
 }
 /**
- * @brief Get a complete frame from USART2 (nonblocking)
- * @param buf Buffer for data (data will be null terminated for easier string manipulation)
+ * @brief Get a complete frame from a channel without copying it (nonblocking)
+ * @details If the frame is contiguous in the RX buffer, a pointer
+ * into the buffer is returned, otherwise (frame wraps around the end
+ * of buffer) it is copied into a scratch buffer. The terminator is
+ * replaced by a NULL terminator. The frame stays valid until
+ * COMM_ChannelReleaseFrame is called, which has to be done before
+ * getting the next frame.
+ *
+ * Frames longer than COMM_FRAME_MAX (with terminator) are dropped.
+ * If so much data without terminator is waiting, it is dropped
+ * right away together with the rest of the frame, when it arrives,
+ * so that the parser resynchronizes on the next terminator.
+ *
+ * @param ch Channel
+ * @param buf Pointer to frame data
  * @param len Length not including terminator character
  * @retval 0 Received frame
  * @retval 1 No frame in buffer
- * @retval 2 Frame error
- * TODO Add maximum length checking so as not to overflow
+ * @retval 2 Frame dropped
  */
-uint8_t COMM_GetFrame(uint8_t* buf, uint8_t* len) {
+uint8_t COMM_ChannelGetFrameRef(COMM_Channel_TypeDef* ch, uint8_t** buf, uint16_t* len) {
+
+  uint16_t pos;
+  uint8_t* span;
 
-  uint8_t c;
   *len = 0; // zero out length variable
 
-  if (gotFrame) {
-    while (1) {
+  if (!ch->gotFrame) {
 
-      // no more data and terminator wasn't reached => error
-      if (FIFO_IsEmpty(&rxFifo)) {
-        *len = 0;
-        println("Invalid frame");
-        return 2;
-      }
-      FIFO_Pop(&rxFifo, &c);
-      buf[(*len)++] = c;
+    uint16_t count = FIFO_GetCount(&ch->rxFifo);
 
-      // if end of frame
-      if (c == COMM_TERMINATOR) {
-        (*len)--; // length without terminator character
-        buf[*len] = 0; // USART terminator character converted to NULL terminator
-        break;
+    // oversize frame - don't wait for terminator, the buffer would fill up
+    if (count >= COMM_FRAME_MAX && FIFO_Find(&ch->rxFifo, COMM_TERMINATOR, &pos)) {
+      FIFO_Discard(&ch->rxFifo, count);
+      if (!ch->discarding) {
+        ch->discarding = 1;
+        ch->framesDropped++;
+        println("Frame too long");
       }
-
+      return 2;
     }
-    gotFrame--;
-    return 0;
+    return 1;
+  }
+
+  __sync_sub_and_fetch(&ch->gotFrame, 1);
+
+  // every counted terminator is in the buffer
+  FIFO_Find(&ch->rxFifo, COMM_TERMINATOR, &pos);
+
+  // end of dropped oversize frame
+  if (ch->discarding) {
+    ch->discarding = 0;
+    FIFO_Discard(&ch->rxFifo, pos + 1);
+    return 2;
+  }
+
+  if (pos >= COMM_FRAME_MAX) {
+    FIFO_Discard(&ch->rxFifo, pos + 1);
+    ch->framesDropped++;
+    println("Frame too long");
+    return 2;
+  }
 
+  if (FIFO_GetSpan(&ch->rxFifo, &span) > pos) {
+    // frame is contiguous - parse it in place
+    span[pos] = 0; // USART terminator character converted to NULL terminator
+    *buf = span;
+    ch->frameLen = pos + 1; // released together with terminator
   } else {
+    // frame wraps around - copy it
+    FIFO_PopBuf(&ch->rxFifo, ch->frameBuffer, pos + 1);
+    ch->frameBuffer[pos] = 0;
+    *buf = ch->frameBuffer;
+    ch->frameLen = 0; // already removed from FIFO
+  }
 
-    return 1;
+  *len = pos;
+
+  return 0;
+}
+/**
+ * @brief Release frame got by COMM_ChannelGetFrameRef.
+ * @details Frees the space in the RX buffer.
+ * @param ch Channel
+ */
+void COMM_ChannelReleaseFrame(COMM_Channel_TypeDef* ch) {
+
+  FIFO_Discard(&ch->rxFifo, ch->frameLen);
+  ch->frameLen = 0;
+}
+/**
+ * @brief Get a complete frame from a channel (nonblocking)
+ * @param ch Channel
+ * @param buf Buffer for data (data will be null terminated for easier string manipulation)
+ * @param maxLen Length of buffer (frames which don't fit with NULL terminator are dropped)
+ * @param len Length not including terminator character
+ * @retval 0 Received frame
+ * @retval 1 No frame in buffer
+ * @retval 2 Frame dropped
+ */
+uint8_t COMM_ChannelGetFrame(COMM_Channel_TypeDef* ch, uint8_t* buf, uint16_t maxLen, uint16_t* len) {
+
+  uint8_t* frame;
+  uint16_t size;
+
+  uint8_t ret = COMM_ChannelGetFrameRef(ch, &frame, &size);
+
+  if (ret) {
+    return ret;
+  }
+
+  if (size >= maxLen) {
+    COMM_ChannelReleaseFrame(ch);
+    ch->framesDropped++;
+    println("Frame too long");
+    return 2;
   }
 
+  memcpy(buf, frame, size + 1); // copy with NULL terminator
+  *len = size;
+
+  COMM_ChannelReleaseFrame(ch);
+
+  return 0;
+}
+/**
+ * @brief Get overflow statistics.
+ * @details Overflows are only counted, nothing is printed when
+ * they happen (printing would need the full TX buffer).
+ * @param ch Channel
+ * @param stats Statistics
+ */
+void COMM_ChannelGetStats(COMM_Channel_TypeDef* ch, COMM_Stats_TypeDef* stats) {
+
+  stats->txDropped      = FIFO_GetDropped(&ch->txFifo);
+  stats->rxDropped      = FIFO_GetDropped(&ch->rxFifo);
+  stats->framesDropped  = ch->framesDropped;
+  stats->txTimeouts     = ch->txTimeouts;
+}
+/**
+ * @brief Checks baud rate which would be achieved on console.
+ * @param baud Required baud rate
+ * @param error Relative error of achieved baud rate in ppm
+ * @return Achieved baud rate
+ */
+uint32_t COMM_CheckBaud(uint32_t baud, int32_t* error) {
+
+  return COMM_ChannelCheckBaud(&console, baud, error);
+}
+/**
+ * @brief Changes baud rate of console.
+ * @param baud Required baud rate
+ * @return Achieved baud rate
+ * @warning Blocking function! Waits until TX buffer is empty.
+ */
+uint32_t COMM_SetBaud(uint32_t baud) {
+
+  return COMM_ChannelSetBaud(&console, baud);
+}
+/**
+ * @brief Get baud rate of console.
+ * @return Achieved baud rate
+ */
+uint32_t COMM_GetBaud(void) {
+
+  return COMM_ChannelGetBaud(&console);
+}
+/**
+ * @brief Get usage statistics of channel buffers.
+ * @details Use them to size the buffers.
+ * @param ch Channel
+ * @param rx RX buffer statistics
+ * @param tx TX buffer statistics
+ */
+void COMM_ChannelGetBufferStats(COMM_Channel_TypeDef* ch, FIFO_Stats_TypeDef* rx, FIFO_Stats_TypeDef* tx) {
+
+  FIFO_GetStats(&ch->rxFifo, rx);
+  FIFO_GetStats(&ch->txFifo, tx);
+}
+/**
+ * @brief Reset all statistics of a channel.
+ * @param ch Channel
+ */
+void COMM_ChannelResetStats(COMM_Channel_TypeDef* ch) {
+
+  FIFO_ResetStats(&ch->rxFifo);
+  FIFO_ResetStats(&ch->txFifo);
+  ch->framesDropped = 0;
+  ch->txTimeouts    = 0;
+}
+/**
+ * @brief Send a char to console.
+ * @param c Char to send.
+ */
+void COMM_Putc(uint8_t c) {
+
+  COMM_ChannelWrite(&console, &c, 1);
+}
+/**
+ * @brief Send a block of data to console.
+ * @details This is the path used by printf (see stubs.c _write function).
+ * @param buf Data to send.
+ * @param len Number of bytes.
+ * @return Number of bytes accepted
+ */
+uint16_t COMM_Write(const uint8_t* buf, uint16_t len) {
+
+  return COMM_ChannelWrite(&console, buf, len);
+}
+/**
+ * @brief Reserve contiguous space in console TX buffer.
+ * @param len Number of bytes needed
+ * @return Start of reserved space (NULL - not enough contiguous space)
+ */
+uint8_t* COMM_TxReserve(uint16_t len) {
+
+  return COMM_ChannelTxReserve(&console, len);
+}
+/**
+ * @brief Reserve all free space in console TX buffer.
+ * @param span Two spans of free space
+ * @return Number of free bytes in both spans
+ */
+uint16_t COMM_TxReserve2(FIFO_Span_TypeDef* span) {
+
+  return COMM_ChannelTxReserve2(&console, span);
+}
+/**
+ * @brief Send data written into reserved console TX space.
+ * @param len Number of bytes written
+ */
+void COMM_TxCommit(uint16_t len) {
+
+  COMM_ChannelTxCommit(&console, len);
+}
+/**
+ * @brief Sets console policy for data which doesn't fit into TX buffer.
+ * @param policy Overflow policy
+ * @param timeout Maximum waiting time in ms (for COMM_TX_BLOCK)
+ */
+void COMM_SetTxPolicy(COMM_TxPolicy_TypeDef policy, uint32_t timeout) {
+
+  COMM_ChannelSetTxPolicy(&console, policy, timeout);
+}
+/**
+ * @brief Get free space in console transmit buffer.
+ * @return Number of chars which can be sent without loss
+ */
+uint16_t COMM_GetTxFree(void) {
+
+  return COMM_ChannelGetTxFree(&console);
+}
+/**
+ * @brief Get a char from console
+ * @return Received char.
+ * @warning Blocking function! Waits until char is received.
+ */
+uint8_t COMM_Getc(void) {
+
+  return COMM_ChannelGetc(&console);
+}
+/**
+ * @brief Get a complete frame from console without copying it (nonblocking)
+ * @param buf Pointer to frame data
+ * @param len Length not including terminator character
+ * @retval 0 Received frame
+ * @retval 1 No frame in buffer
+ * @retval 2 Frame dropped
+ */
+uint8_t COMM_GetFrameRef(uint8_t** buf, uint16_t* len) {
+
+  return COMM_ChannelGetFrameRef(&console, buf, len);
+}
+/**
+ * @brief Release frame got by COMM_GetFrameRef.
+ */
+void COMM_ReleaseFrame(void) {
+
+  COMM_ChannelReleaseFrame(&console);
+}
+/**
+ * @brief Get a complete frame from console (nonblocking)
+ * @param buf Buffer for data
+ * @param maxLen Length of buffer
+ * @param len Length not including terminator character
+ * @retval 0 Received frame
+ * @retval 1 No frame in buffer
+ * @retval 2 Frame dropped
+ */
+uint8_t COMM_GetFrame(uint8_t* buf, uint16_t maxLen, uint16_t* len) {
+
+  return COMM_ChannelGetFrame(&console, buf, maxLen, len);
+}
+/**
+ * @brief Get console overflow statistics.
+ * @param stats Statistics
+ */
+void COMM_GetStats(COMM_Stats_TypeDef* stats) {
+
+  COMM_ChannelGetStats(&console, stats);
+}
+/**
+ * @brief Get usage statistics of console buffers.
+ * @param rx RX buffer statistics
+ * @param tx TX buffer statistics
+ */
+void COMM_GetBufferStats(FIFO_Stats_TypeDef* rx, FIFO_Stats_TypeDef* tx) {
+
+  COMM_ChannelGetBufferStats(&console, rx, tx);
+}
+/**
+ * @brief Reset all console statistics.
+ */
+void COMM_ResetStats(void) {
+
+  COMM_ChannelResetStats(&console);
 }
 /**
  * @brief Callback for receiving data from PC.
- * @param c Data sent from lower layer software.
+ * @details Lower layer passes data in blocks.
+ * @param ctx Channel
+ * @param buf Data sent from lower layer software.
+ * @param len Number of bytes
  */
-void COMM_RxCallback(uint8_t c) {
+static void COMM_RxCallback(void* ctx, uint8_t* buf, uint16_t len) {
+
+  COMM_Channel_TypeDef* ch = ctx;
 
-  uint8_t res = FIFO_Push(&rxFifo, c); // Put data in RX buffer
+  len = FIFO_PushBuf(&ch->rxFifo, buf, len); // Put data in RX buffer
 
-  // Checking res to ensure no buffer overflow occurred
-  if ((c == COMM_TERMINATOR) && (res == 0)) {
-    gotFrame++;
+  // count terminators only in data which fit into buffer
+  uint8_t* end = buf + len;
+  while ((buf = memchr(buf, COMM_TERMINATOR, end - buf)) != NULL) {
+    __sync_add_and_fetch(&ch->gotFrame, 1);
+    buf++;
   }
 }
 /**
  * @brief Callback for transmitting data to lower layer
- * @param c Transmitted data
- * @retval 0 There is no more data in buffer (stop transmitting)
- * @retval 1 Valid data in c
+ * @details Lower layer sends the returned span directly from
+ * the TX buffer and calls back when it is done.
+ * @param ctx Channel
+ * @param sent Number of bytes sent from previous span
+ * @param buf Start of next span to send
+ * @return Length of next span (0 - no more data, stop transmitting)
  */
-uint8_t COMM_TxCallback(uint8_t* c) {
+static uint16_t COMM_TxCallback(void* ctx, uint16_t sent, uint8_t** buf) {
 
-  if (FIFO_Pop(&txFifo, c) == 0) { // If buffer not empty
-    return 1;
-  } else {
-    return 0;
-  }
+  COMM_Channel_TypeDef* ch = ctx;
+
+  FIFO_Discard(&ch->txFifo, sent); // free sent data
 
+  return FIFO_GetSpan(&ch->txFifo, buf);
 }
 
 /**
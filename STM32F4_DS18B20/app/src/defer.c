@@ -0,0 +1,139 @@
+/**
+ * @file:   defer.c
+ * @brief:  Deferred callback queue
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @details Interrupt handlers and soft timers post callbacks
+ * (with a context pointer) into this queue and the main loop
+ * runs them with DEFER_Run. Posting is lock-free, so it can
+ * be done from any interrupt priority, and it never calls
+ * the callback itself, which keeps ISR time minimal.
+ *
+ * Producers reserve a slot by atomically incrementing the head
+ * index and then mark the slot ready once it is filled. The
+ * single consumer (main loop) runs ready slots in order.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <defer.h>
+#include <stdio.h>
+
+/**
+ * @addtogroup DEFER
+ * @{
+ */
+
+#define DEFER_QUEUE_LEN   32                    ///< Queue length (has to be a power of two)
+#define DEFER_QUEUE_MASK  (DEFER_QUEUE_LEN - 1) ///< Mask for wrapping indices
+
+/**
+ * @brief Deferred work item.
+ */
+typedef struct {
+  DEFER_Callback fun;     ///< Callback function
+  void* ctx;              ///< Context passed to callback
+  volatile uint8_t ready; ///< Nonzero when item is filled by producer
+} DEFER_Item_TypeDef;
+
+static DEFER_Item_TypeDef queue[DEFER_QUEUE_LEN]; ///< Work items
+
+static volatile uint32_t head;    ///< Next slot to reserve (free running)
+static volatile uint32_t tail;    ///< Next slot to run (free running)
+static volatile uint32_t dropped; ///< Number of items dropped due to full queue
+
+/**
+ * @brief Post a callback to the deferred queue.
+ * @details Safe to call from interrupts and from the main loop.
+ * @param fun Callback function
+ * @param ctx Context pointer passed to callback
+ * @retval 0 Callback queued
+ * @retval 1 Error: queue full or NULL callback
+ */
+uint8_t DEFER_Post(DEFER_Callback fun, void* ctx) {
+
+  uint32_t slot;
+
+  if (fun == NULL) {
+    return 1;
+  }
+
+  // reserve a slot - retry if another producer got in between
+  do {
+    slot = head;
+    if (slot - tail >= DEFER_QUEUE_LEN) {
+      __sync_fetch_and_add(&dropped, 1);
+      return 1;
+    }
+  } while (!__sync_bool_compare_and_swap(&head, slot, slot + 1));
+
+  queue[slot & DEFER_QUEUE_MASK].fun = fun;
+  queue[slot & DEFER_QUEUE_MASK].ctx = ctx;
+
+  __sync_synchronize(); // data has to be visible before ready flag
+
+  queue[slot & DEFER_QUEUE_MASK].ready = 1;
+
+  return 0;
+}
+
+/**
+ * @brief Runs queued callbacks.
+ *
+ * @details This function should be called periodically in the main
+ * loop of the program. Work per call is bounded by maxItems, so
+ * the main loop latency stays predictable.
+ *
+ * @param maxItems Maximum number of callbacks to run
+ * @return Number of callbacks run
+ */
+uint8_t DEFER_Run(uint8_t maxItems) {
+
+  uint8_t count = 0;
+  DEFER_Callback fun;
+  void* ctx;
+
+  while (count < maxItems) {
+
+    DEFER_Item_TypeDef* item = &queue[tail & DEFER_QUEUE_MASK];
+
+    // items run in order - stop at first one not yet filled
+    if (!item->ready) {
+      break;
+    }
+
+    fun = item->fun;
+    ctx = item->ctx;
+    item->ready = 0;
+
+    __sync_synchronize(); // free slot only after it was read
+
+    tail++;
+
+    fun(ctx);
+    count++;
+  }
+
+  return count;
+}
+
+/**
+ * @brief Get number of callbacks dropped because queue was full.
+ * @return Number of dropped callbacks
+ */
+uint32_t DEFER_GetDropped(void) {
+  return dropped;
+}
+
+/**
+ * @}
+ */
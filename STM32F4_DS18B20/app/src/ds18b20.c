@@ -24,14 +24,13 @@
 
 #include <ds18b20.h>
 #include <onewire.h>
+#include <log.h>
 
-#include <stdio.h>
-
-#define DEBUG ///< If defined, program sends all printf data to the USART
+#define DEBUG ///< If defined, messages are logged (see LOG)
 
 #ifdef DEBUG
-#define print(str, args...) printf("DS18B20--> "str"%s",##args,"\r")
-#define println(str, args...) printf("DS18B20--> "str"%s",##args,"\r\n")
+#define print(str, args...) LOG("DS18B20--> "str"\r", ##args)
+#define println(str, args...) LOG("DS18B20--> "str"\r\n", ##args)
 #else
 #define print(str, args...) (void)0
 #define println(str, args...) (void)0
@@ -141,11 +140,11 @@ void DS18B20_ReadScratchPad(uint8_t* buf) {
 
 }
 /**
- * @brief Reads DS18B20 temperature.
+ * @brief Reads DS18B20 temperature in fixed point format.
  *
- * @return Temperature value in degrees Celsius
+ * @return Temperature value in 1/16 degrees Celsius
  */
-double DS18B20_ReadTemp(void) {
+int16_t DS18B20_ReadTempRaw(void) {
 
   uint8_t mem[10];
 
@@ -153,30 +152,15 @@ double DS18B20_ReadTemp(void) {
 
   DS18B20_Memory* dsMem = (DS18B20_Memory*)mem;
 
-  uint8_t t1 = (dsMem->tempLSB >> 4) & 0x0f;
-
-  t1 |= ((dsMem->tempMSB << 4) & 0x70);
-
-  double t2 = 0;
-
-  if (dsMem->tempLSB & 0x08) {
-    t2 += 0.5;
-  }
-
-  if (dsMem->tempLSB & 0x04) {
-    t2 += 0.25;
-  }
-
-  if (dsMem->tempLSB & 0x02) {
-    t2 += 0.125;
-  }
-
-  if (dsMem->tempLSB & 0x01) {
-    t2 += 0.0625;
-  }
-
-  double ret = (double)t1 + t2;
-
-  return ret;
+  // sign extended two's complement value with 4 fractional bits
+  return (int16_t)((dsMem->tempMSB << 8) | dsMem->tempLSB);
+}
+/**
+ * @brief Reads DS18B20 temperature.
+ *
+ * @return Temperature value in degrees Celsius
+ */
+double DS18B20_ReadTemp(void) {
 
+  return DS18B20_ReadTempRaw() / 16.0;
 }
@@ -17,14 +17,16 @@
 
 #include <fifo.h>
 #include <stdio.h>
+#include <log.h>
+#include <string.h>
 
 #ifndef DEBUG
   #define DEBUG
 #endif
 
 #ifdef DEBUG
-  #define print(str, args...) printf("FIFO--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("FIFO--> "str"%s",##args,"\r\n")
+  #define print(str, args...) LOG("FIFO--> "str"\r", ##args)
+  #define println(str, args...) LOG("FIFO--> "str"\r\n", ##args)
 #else
   #define print(str, args...) (void)0
   #define println(str, args...) (void)0
@@ -35,16 +37,89 @@
  * @{
  */
 
+/**
+ * @brief Memory barrier - data accesses complete before index update.
+ */
+#define FIFO_BARRIER() __sync_synchronize()
+
+static uint32_t (*timeSource)(void); ///< Time source for statistics (NULL - time not measured)
+
+/**
+ * @brief Get time for statistics.
+ * @return Current time
+ */
+static uint32_t FIFO_GetTime(void) {
+
+  if (!timeSource) { // if NULL
+    return 0;
+  }
+
+  return timeSource();
+}
+/**
+ * @brief Starts full period.
+ * @details Call only from the producer side.
+ * @param fifo Pointer to FIFO structure
+ */
+static void FIFO_SetFull(FIFO_TypeDef* fifo) {
+
+  if (!fifo->stats.full) {
+    fifo->stats.fullStart = FIFO_GetTime();
+    FIFO_BARRIER(); // start time valid before flag
+    fifo->stats.full = 1;
+  }
+}
+/**
+ * @brief Ends full period after space was freed.
+ * @details Call only from the consumer side. If the producer
+ * fills the FIFO while the flag is checked, the period ends
+ * on the next freeing call instead.
+ * @param fifo Pointer to FIFO structure
+ */
+static void FIFO_ClearFull(FIFO_TypeDef* fifo) {
+
+  if (fifo->stats.full) {
+    fifo->stats.fullTime += FIFO_GetTime() - fifo->stats.fullStart;
+    FIFO_BARRIER();
+    fifo->stats.full = 0;
+  }
+}
+/**
+ * @brief Updates statistics after data was pushed.
+ * @param fifo Pointer to FIFO structure
+ * @param head Head after push
+ */
+static void FIFO_UpdateStats(FIFO_TypeDef* fifo, uint16_t head) {
+
+  FIFO_Stats_TypeDef* stats = &fifo->stats;
+  uint16_t count = head - fifo->tail;
+  uint32_t bin = (uint32_t)count * FIFO_HIST_BINS / fifo->len;
+
+  if (bin >= FIFO_HIST_BINS) { // full FIFO goes to last bin
+    bin = FIFO_HIST_BINS - 1;
+  }
+  stats->histogram[bin]++;
+
+  if (count > stats->highWater) {
+    stats->highWater = count;
+  }
+
+  if (count == fifo->len) { // push left no free space
+    FIFO_SetFull(fifo);
+  }
+}
+
 /**
  * @brief Add a FIFO.
  *
  * @details To add a FIFO, you need to define a FIFO_TypeDef
  * structure and initialize it with the proper length and
- * buffer pointer. The rest is handled automatically.
+ * buffer pointer (and overflow policy if other than the default
+ * FIFO_DROP_NEWEST). The rest is handled automatically.
  *
  * @param fifo Pointer to FIFO structure
  * @retval 0 FIFO added successfully
- * @retval 1 Error: FIFO length is 0
+ * @retval 1 Error: FIFO length is 0 or not a power of two
  */
 uint8_t FIFO_Add(FIFO_TypeDef* fifo) {
 
@@ -53,39 +128,237 @@ uint8_t FIFO_Add(FIFO_TypeDef* fifo) {
     return 1;
   }
 
+  if (fifo->len & (fifo->len - 1)) {
+    println("FIFO length not a power of two");
+    return 1;
+  }
+
   fifo->tail  = 0;
   fifo->head  = 0;
-  fifo->count = 0;
+  fifo->mask  = fifo->len - 1;
+  FIFO_ResetStats(fifo);
+
+  return 0;
+}
+/**
+ * @brief Frees space at the tail of FIFO.
+ * @details With FIFO_DROP_OLDEST the producer can move the tail
+ * as well, so the update is done atomically and fails if the tail
+ * was moved in the meantime (data read from old tail might have
+ * been overwritten then).
+ * @param fifo Pointer to FIFO structure
+ * @param tail Tail the data was read from
+ * @param newTail New tail
+ * @retval 0 Space freed
+ * @retval 1 Tail was moved by producer - read again
+ */
+static uint8_t FIFO_SetTail(FIFO_TypeDef* fifo, uint16_t tail, uint16_t newTail) {
+
+  FIFO_BARRIER();
+
+  if (fifo->policy == FIFO_DROP_OLDEST) {
+    return !__sync_bool_compare_and_swap(&fifo->tail, tail, newTail);
+  }
+
+  fifo->tail = newTail;
 
   return 0;
 }
+/**
+ * @brief Counts dropped data.
+ * @details Call only from the producer side.
+ * @param fifo Pointer to FIFO structure
+ * @param len Number of bytes dropped
+ */
+static void FIFO_CountDrop(FIFO_TypeDef* fifo, uint16_t len) {
+
+  __sync_fetch_and_add(&fifo->dropped, len);
+
+  fifo->stats.overflows++;
+  FIFO_SetFull(fifo); // data is only dropped when there is no space
+}
+/**
+ * @brief Makes space for data which doesn't fit.
+ * @details Call only from the producer side.
+ * @param fifo Pointer to FIFO structure
+ * @param head Current head
+ * @param len Number of bytes to push
+ * @return Number of bytes which can be pushed
+ */
+static uint16_t FIFO_Overflow(FIFO_TypeDef* fifo, uint16_t head, uint16_t len) {
+
+  uint16_t tail;
+  uint16_t free;
+
+  if (fifo->policy == FIFO_DROP_OLDEST) {
+
+    // drop oldest data, unless consumer freed enough in the meantime
+    do {
+      tail = fifo->tail;
+      free = fifo->len - (uint16_t)(head - tail);
+      if (len <= free) {
+        return len;
+      }
+    } while (!__sync_bool_compare_and_swap(&fifo->tail, tail, head + len - fifo->len));
+
+    FIFO_CountDrop(fifo, len - free);
+    return len;
+  }
+
+  free = fifo->len - (uint16_t)(head - fifo->tail);
+  if (len <= free) {
+    return len;
+  }
+
+  FIFO_CountDrop(fifo, len - free);
+  return free;
+}
 /**
  * @brief Pushes data to FIFO.
+ * @details Call only from the producer side.
  * @param fifo Pointer to FIFO structure
  * @param c Data byte
  * @retval 0 Data added
- * @retval 1 Error: FIFO is full
+ * @retval 1 Error: FIFO is full (data dropped)
  */
 uint8_t FIFO_Push(FIFO_TypeDef* fifo, uint8_t c) {
 
+  uint16_t head = fifo->head;
+
   // Check for overflow
-  if (fifo->count == fifo->len) {
-    println("FIFO overflow");
-    return 1;
+  if ((uint16_t)(head - fifo->tail) == fifo->len) {
+    if (FIFO_Overflow(fifo, head, 1) == 0) {
+      return 1;
+    }
   }
 
-  fifo->buf[fifo->head++] = c; // Put char in buffer
-  fifo->count++; // Increase counter
+  fifo->buf[head & fifo->mask] = c; // Put char in buffer
 
+  FIFO_BARRIER();
+  fifo->head = head + 1; // publish data
 
-  if (fifo->head == fifo->len) {
-    fifo->head = 0; // start from beginning
-  }
+  FIFO_UpdateStats(fifo, head + 1);
 
   return 0;
 }
+/**
+ * @brief Pushes a block of data to FIFO.
+ * @details Data is copied with at most two memcpy calls.
+ * Call only from the producer side.
+ * @param fifo Pointer to FIFO structure
+ * @param buf Data
+ * @param len Number of bytes
+ * @return Number of bytes pushed (less than len if FIFO got full
+ * and the rest was dropped)
+ */
+uint16_t FIFO_PushBuf(FIFO_TypeDef* fifo, const uint8_t* buf, uint16_t len) {
+
+  uint16_t head = fifo->head;
+  uint16_t free = fifo->len - (uint16_t)(head - fifo->tail);
+
+  if (len > free) {
+
+    // only the newest data can fit
+    if (fifo->policy == FIFO_DROP_OLDEST && len > fifo->len) {
+      FIFO_CountDrop(fifo, len - fifo->len);
+      buf += len - fifo->len;
+      len = fifo->len;
+    }
+    len = FIFO_Overflow(fifo, head, len);
+  }
+
+  if (len == 0) { // nothing stored - not an occupancy sample
+    return 0;
+  }
+
+  // first part up to the end of buffer
+  uint16_t start = head & fifo->mask;
+  uint16_t first = fifo->len - start;
+  if (first > len) {
+    first = len;
+  }
+
+  memcpy(&fifo->buf[start], buf, first);
+  memcpy(fifo->buf, buf + first, len - first); // wrapped part
+
+  FIFO_BARRIER();
+  fifo->head = head + len; // publish data
+
+  FIFO_UpdateStats(fifo, head + len);
+
+  return len;
+}
+/**
+ * @brief Reserve contiguous free space in FIFO.
+ * @details Data is written in place and published with
+ * FIFO_Commit. Call only from the producer side.
+ * @param fifo Pointer to FIFO structure
+ * @param len Number of bytes needed
+ * @return Start of reserved space (NULL - not enough contiguous space)
+ */
+uint8_t* FIFO_Reserve(FIFO_TypeDef* fifo, uint16_t len) {
+
+  FIFO_Span_TypeDef span[2];
+
+  if (FIFO_Reserve2(fifo, span) < len || span[0].len < len) {
+    return NULL;
+  }
+
+  return span[0].buf;
+}
+/**
+ * @brief Reserve all free space in FIFO.
+ * @details Free space wrapping around the end of buffer is
+ * returned as two spans (second span is empty otherwise). Data
+ * is written in place and published with FIFO_Commit. Call only
+ * from the producer side.
+ * @param fifo Pointer to FIFO structure
+ * @param span Two spans of free space
+ * @return Number of free bytes in both spans
+ */
+uint16_t FIFO_Reserve2(FIFO_TypeDef* fifo, FIFO_Span_TypeDef* span) {
+
+  uint16_t head = fifo->head;
+  uint16_t free = fifo->len - (uint16_t)(head - fifo->tail);
+
+  // first part up to the end of buffer
+  uint16_t start = head & fifo->mask;
+  uint16_t first = fifo->len - start;
+  if (first > free) {
+    first = free;
+  }
+
+  FIFO_BARRIER(); // consumer finished reading freed data
+
+  span[0].buf = &fifo->buf[start];
+  span[0].len = first;
+  span[1].buf = fifo->buf; // wrapped part
+  span[1].len = free - first;
+
+  return free;
+}
+/**
+ * @brief Publish data written into reserved space.
+ * @details Call only from the producer side.
+ * @param fifo Pointer to FIFO structure
+ * @param len Number of bytes written (not more than reserved)
+ */
+void FIFO_Commit(FIFO_TypeDef* fifo, uint16_t len) {
+
+  if (len == 0) { // nothing stored - not an occupancy sample
+    return;
+  }
+
+  uint16_t head = fifo->head + len;
+
+  FIFO_BARRIER();
+  fifo->head = head; // publish data
+
+  FIFO_UpdateStats(fifo, head);
+}
 /**
  * @brief Pops data from the FIFO.
+ * @details Call only from the consumer side.
  * @param fifo Pointer to FIFO structure
  * @param c data
  * @retval 0 Got valid data
@@ -93,19 +366,262 @@ uint8_t FIFO_Push(FIFO_TypeDef* fifo, uint8_t c) {
  */
 uint8_t FIFO_Pop(FIFO_TypeDef* fifo, uint8_t* c) {
 
-  // If FIFO is empty
-  if (fifo->count == 0) {
-//    println("FIFO is empty");
-    return 1;
+  uint16_t tail;
+
+  do {
+    tail = fifo->tail;
+
+    // If FIFO is empty
+    if (tail == fifo->head) {
+      return 1;
+    }
+
+    FIFO_BARRIER();
+    *c = fifo->buf[tail & fifo->mask];
+
+  } while (FIFO_SetTail(fifo, tail, tail + 1)); // free space
+
+  FIFO_ClearFull(fifo);
+
+  return 0;
+}
+/**
+ * @brief Pops a block of data from FIFO.
+ * @details Data is copied with at most two memcpy calls.
+ * Call only from the consumer side.
+ * @param fifo Pointer to FIFO structure
+ * @param buf Buffer for data
+ * @param len Maximum number of bytes
+ * @return Number of bytes popped
+ */
+uint16_t FIFO_PopBuf(FIFO_TypeDef* fifo, uint8_t* buf, uint16_t len) {
+
+  uint16_t tail;
+  uint16_t count;
+  uint16_t max = len;
+
+  do {
+    tail = fifo->tail;
+    count = fifo->head - tail;
+
+    len = max;
+    if (len > count) {
+      len = count;
+    }
+
+    FIFO_BARRIER();
+
+    // first part up to the end of buffer
+    uint16_t start = tail & fifo->mask;
+    uint16_t first = fifo->len - start;
+    if (first > len) {
+      first = len;
+    }
+
+    memcpy(buf, &fifo->buf[start], first);
+    memcpy(buf + first, fifo->buf, len - first); // wrapped part
+
+  } while (FIFO_SetTail(fifo, tail, tail + len)); // free space
+
+  if (len) {
+    FIFO_ClearFull(fifo);
   }
-  *c = fifo->buf[fifo->tail++];
-  fifo->count--;
 
-  if (fifo->tail == fifo->len) {
-    fifo->tail = 0; // start from beginning
+  return len;
+}
+/**
+ * @brief Copy data from FIFO without removing it.
+ * @details Use FIFO_Discard once the data has been processed.
+ * Call only from the consumer side.
+ * @param fifo Pointer to FIFO structure
+ * @param offset Offset from the tail of FIFO
+ * @param buf Buffer for data
+ * @param len Number of bytes to copy
+ * @return Number of bytes copied
+ */
+uint16_t FIFO_PeekBuf(FIFO_TypeDef* fifo, uint16_t offset, uint8_t* buf, uint16_t len) {
+
+  uint16_t tail = fifo->tail;
+  uint16_t count = fifo->head - tail;
+
+  if (offset >= count) {
+    return 0;
+  }
+  if (len > count - offset) {
+    len = count - offset;
   }
 
-  return 0;
+  FIFO_BARRIER();
+
+  uint16_t start = (tail + offset) & fifo->mask;
+  uint16_t first = fifo->len - start;
+  if (first > len) {
+    first = len;
+  }
+
+  memcpy(buf, &fifo->buf[start], first);
+  memcpy(buf + first, fifo->buf, len - first); // wrapped part
+
+  return len;
+}
+/**
+ * @brief Get contiguous span of data at the tail of FIFO.
+ * @details Data is not removed - use FIFO_Discard after
+ * it has been processed (e.g. sent by DMA).
+ * Call only from the consumer side. Not allowed with the
+ * FIFO_DROP_OLDEST policy - the producer could overwrite the span
+ * while it is used.
+ * @param fifo Pointer to FIFO structure
+ * @param buf Pointer to start of span
+ * @return Number of bytes in span (0 - FIFO is empty or policy
+ * is FIFO_DROP_OLDEST)
+ */
+uint16_t FIFO_GetSpan(FIFO_TypeDef* fifo, uint8_t** buf) {
+
+  if (fifo->policy == FIFO_DROP_OLDEST) {
+    println("No spans with FIFO_DROP_OLDEST policy");
+    return 0;
+  }
+
+  uint16_t tail = fifo->tail;
+  uint16_t len = fifo->head - tail;
+  uint16_t start = tail & fifo->mask;
+
+  // span ends at the end of buffer
+  if (len > fifo->len - start) {
+    len = fifo->len - start;
+  }
+
+  FIFO_BARRIER();
+  *buf = &fifo->buf[start];
+
+  return len;
+}
+/**
+ * @brief Finds first occurrence of a byte in FIFO.
+ * @details Data is searched with at most two memchr calls
+ * and is not removed. Call only from the consumer side.
+ * @param fifo Pointer to FIFO structure
+ * @param c Byte to find
+ * @param pos Offset of byte from the tail of FIFO
+ * @retval 0 Byte found
+ * @retval 1 Byte not found
+ */
+uint8_t FIFO_Find(FIFO_TypeDef* fifo, uint8_t c, uint16_t* pos) {
+
+  uint16_t tail = fifo->tail;
+  uint16_t len = fifo->head - tail;
+
+  FIFO_BARRIER();
+
+  // first part up to the end of buffer
+  uint16_t start = tail & fifo->mask;
+  uint16_t first = fifo->len - start;
+  if (first > len) {
+    first = len;
+  }
+
+  uint8_t* p = memchr(&fifo->buf[start], c, first);
+  if (p != NULL) {
+    *pos = p - &fifo->buf[start];
+    return 0;
+  }
+
+  p = memchr(fifo->buf, c, len - first); // wrapped part
+  if (p != NULL) {
+    *pos = first + (p - fifo->buf);
+    return 0;
+  }
+
+  return 1;
+}
+/**
+ * @brief Removes data from the tail of FIFO.
+ * @details Call only from the consumer side.
+ * @param fifo Pointer to FIFO structure
+ * @param len Number of bytes to remove
+ */
+void FIFO_Discard(FIFO_TypeDef* fifo, uint16_t len) {
+
+  uint16_t tail;
+  uint16_t count;
+  uint16_t max = len;
+
+  do {
+    tail = fifo->tail;
+    count = fifo->head - tail;
+
+    len = max;
+    if (len > count) {
+      len = count;
+    }
+
+  } while (FIFO_SetTail(fifo, tail, tail + len)); // free space
+
+  if (len) {
+    FIFO_ClearFull(fifo);
+  }
+}
+/**
+ * @brief Get number of bytes in FIFO.
+ * @param fifo Pointer to FIFO structure
+ * @return Number of bytes which can be popped
+ */
+uint16_t FIFO_GetCount(FIFO_TypeDef* fifo) {
+
+  return fifo->head - fifo->tail;
+}
+/**
+ * @brief Get free space in FIFO.
+ * @param fifo Pointer to FIFO structure
+ * @return Number of bytes which can be pushed
+ */
+uint16_t FIFO_GetFree(FIFO_TypeDef* fifo) {
+
+  return fifo->len - (uint16_t)(fifo->head - fifo->tail);
+}
+/**
+ * @brief Get number of bytes dropped on overflow.
+ * @param fifo Pointer to FIFO structure
+ * @return Number of dropped bytes
+ */
+uint32_t FIFO_GetDropped(FIFO_TypeDef* fifo) {
+
+  return fifo->dropped;
+}
+/**
+ * @brief Get usage statistics.
+ * @details Time spent full includes the current full period.
+ * @param fifo Pointer to FIFO structure
+ * @param stats Statistics
+ */
+void FIFO_GetStats(FIFO_TypeDef* fifo, FIFO_Stats_TypeDef* stats) {
+
+  *stats = fifo->stats;
+
+  if (stats->full) {
+    stats->fullTime += FIFO_GetTime() - stats->fullStart;
+  }
+}
+/**
+ * @brief Reset usage statistics and dropped bytes counter.
+ * @details Updates done by the producer at the same time may be lost.
+ * @param fifo Pointer to FIFO structure
+ */
+void FIFO_ResetStats(FIFO_TypeDef* fifo) {
+
+  memset(&fifo->stats, 0, sizeof(FIFO_Stats_TypeDef));
+  fifo->dropped = 0;
+}
+/**
+ * @brief Sets time source for statistics.
+ * @details Time spent full is given in units of this source.
+ * Without a source it isn't measured.
+ * @param getTime Function returning current time
+ */
+void FIFO_SetTimeSource(uint32_t (*getTime)(void)) {
+
+  timeSource = getTime;
 }
 /**
  * @brief Checks whether the FIFO is empty.
@@ -115,7 +631,7 @@ uint8_t FIFO_Pop(FIFO_TypeDef* fifo, uint8_t* c) {
  */
 uint8_t FIFO_IsEmpty(FIFO_TypeDef* fifo) {
 
-  if (fifo->count == 0) {
+  if (fifo->head == fifo->tail) {
     return 1;
   }
 
@@ -0,0 +1,304 @@
+/**
+ * @file:   hrtimer.c
+ * @brief:  High resolution one shot timers
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @details Callbacks can be scheduled with microsecond precision.
+ * The nearest deadlines are loaded into the hardware compare
+ * channels, the rest wait in a list sorted by deadline. When a
+ * channel fires, its callback is run in interrupt context and
+ * the earliest waiting deadline is moved into the freed channel.
+ *
+ * Callbacks run in interrupt, so they should be short. Longer
+ * work can be passed on to the main loop with DEFER_Post.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <hrtimer.h>
+#include <stdio.h>
+#include <log.h>
+// HAL
+#include <timer5.h>
+
+#ifndef DEBUG
+  #define DEBUG
+#endif
+
+#ifdef DEBUG
+  #define print(str, args...) LOG("HRTIMER--> "str"\r", ##args)
+  #define println(str, args...) LOG("HRTIMER--> "str"\r\n", ##args)
+#else
+  #define print(str, args...) (void)0
+  #define println(str, args...) (void)0
+#endif
+
+/**
+ * @addtogroup HRTIMER
+ * @{
+ */
+
+#define HRTIMER_MAX_EVENTS  16 ///< Maximum number of scheduled callbacks
+#define HRTIMER_NONE        -1 ///< No event
+
+/**
+ * @brief Scheduled callback structure.
+ */
+typedef struct {
+  uint32_t deadline;    ///< Time of callback in us
+  DEFER_Callback fun;   ///< Callback function
+  void* ctx;            ///< Context for callback
+  uint8_t used;         ///< Nonzero if event is scheduled
+} HRTIMER_Event_TypeDef;
+
+static HRTIMER_Event_TypeDef events[HRTIMER_MAX_EVENTS]; ///< Scheduled events
+
+static int8_t channelEvent[HRTIMER_HAL_CHANNELS]; ///< Event loaded into each channel
+
+static int8_t pending[HRTIMER_MAX_EVENTS]; ///< Events waiting for a channel (sorted by deadline)
+static uint8_t pendingCount;               ///< Number of waiting events
+
+static void HRTIMER_CompareCallback(uint8_t ch);
+
+/**
+ * @brief Checks if time a is before time b (overflow safe).
+ */
+#define HRTIMER_BEFORE(a, b) ((int32_t)((a) - (b)) < 0)
+
+/**
+ * @brief Initialize high resolution timers.
+ */
+void HRTIMER_Init(void) {
+
+  uint8_t i;
+
+  for (i = 0; i < HRTIMER_HAL_CHANNELS; i++) {
+    channelEvent[i] = HRTIMER_NONE;
+  }
+  pendingCount = 0;
+
+  HRTIMER_HAL_Init(HRTIMER_CompareCallback);
+}
+/**
+ * @brief Update timer after clock change.
+ */
+void HRTIMER_ClockChanged(void) {
+
+  HRTIMER_HAL_UpdateClock();
+}
+/**
+ * @brief Get time of high resolution timer
+ * @return Time in microseconds
+ */
+uint32_t HRTIMER_GetTime(void) {
+
+  return HRTIMER_HAL_GetTime();
+}
+/**
+ * @brief Inserts event into sorted list of waiting events.
+ * @param id Event ID
+ */
+static void HRTIMER_PendingInsert(int8_t id) {
+
+  uint8_t i = pendingCount;
+
+  // shift later deadlines up to make room
+  while (i > 0 && HRTIMER_BEFORE(events[id].deadline,
+      events[pending[i-1]].deadline)) {
+    pending[i] = pending[i-1];
+    i--;
+  }
+
+  pending[i] = id;
+  pendingCount++;
+}
+/**
+ * @brief Loads event into compare channel.
+ * @param ch Channel
+ * @param id Event ID
+ */
+static void HRTIMER_Load(uint8_t ch, int8_t id) {
+
+  channelEvent[ch] = id;
+  HRTIMER_HAL_SetCompare(ch, events[id].deadline);
+}
+/**
+ * @brief Gives a freed channel to the earliest waiting event.
+ * @param ch Channel
+ */
+static void HRTIMER_Refill(uint8_t ch) {
+
+  uint8_t i;
+
+  channelEvent[ch] = HRTIMER_NONE;
+
+  if (pendingCount) {
+    HRTIMER_Load(ch, pending[0]);
+    pendingCount--;
+    for (i = 0; i < pendingCount; i++) {
+      pending[i] = pending[i+1];
+    }
+  }
+}
+/**
+ * @brief Schedule a one shot callback after a given time.
+ * @param us Time from now in microseconds
+ * @param fun Callback function (runs in interrupt context)
+ * @param ctx Context pointer passed to fun
+ * @return Returns the ID of the scheduled callback or error code (-1)
+ * @retval -1 Error: too many callbacks scheduled
+ */
+int8_t HRTIMER_Schedule(uint32_t us, DEFER_Callback fun, void* ctx) {
+
+  return HRTIMER_ScheduleAt(HRTIMER_HAL_GetTime() + us, fun, ctx);
+}
+/**
+ * @brief Schedule a one shot callback at a given time.
+ * @details Useful for timing consecutive steps of a protocol
+ * without accumulating callback latency.
+ * @param time Time of callback in microseconds (see HRTIMER_GetTime)
+ * @param fun Callback function (runs in interrupt context)
+ * @param ctx Context pointer passed to fun
+ * @return Returns the ID of the scheduled callback or error code (-1)
+ * @retval -1 Error: too many callbacks scheduled
+ */
+int8_t HRTIMER_ScheduleAt(uint32_t time, DEFER_Callback fun, void* ctx) {
+
+  int8_t id;
+  uint8_t ch;
+  int8_t latest = HRTIMER_NONE; // channel with latest deadline
+
+  uint32_t lock = HRTIMER_HAL_Lock();
+
+  for (id = 0; id < HRTIMER_MAX_EVENTS; id++) {
+    if (!events[id].used) {
+      break;
+    }
+  }
+
+  if (id == HRTIMER_MAX_EVENTS) {
+    HRTIMER_HAL_Unlock(lock);
+    println("Reached maximum number of callbacks!");
+    return -1;
+  }
+
+  events[id].deadline = time;
+  events[id].fun      = fun;
+  events[id].ctx      = ctx;
+  events[id].used     = 1;
+
+  for (ch = 0; ch < HRTIMER_HAL_CHANNELS; ch++) {
+
+    // free channel - load event directly
+    if (channelEvent[ch] == HRTIMER_NONE) {
+      HRTIMER_Load(ch, id);
+      HRTIMER_HAL_Unlock(lock);
+      return id;
+    }
+
+    if (latest == HRTIMER_NONE || HRTIMER_BEFORE(
+        events[channelEvent[latest]].deadline, events[channelEvent[ch]].deadline)) {
+      latest = ch;
+    }
+  }
+
+  // all channels busy - new event takes the channel with
+  // the latest deadline if it is earlier than that
+  if (HRTIMER_BEFORE(time, events[channelEvent[latest]].deadline)) {
+    HRTIMER_HAL_DisableCompare(latest);
+    HRTIMER_PendingInsert(channelEvent[latest]);
+    HRTIMER_Load(latest, id);
+  } else {
+    HRTIMER_PendingInsert(id);
+  }
+
+  HRTIMER_HAL_Unlock(lock);
+
+  return id;
+}
+/**
+ * @brief Cancel a scheduled callback.
+ * @param id Callback ID
+ * @retval 0 Callback cancelled
+ * @retval 1 Error: callback not scheduled (or already run)
+ */
+uint8_t HRTIMER_Cancel(int8_t id) {
+
+  uint8_t i;
+
+  if (id < 0 || id >= HRTIMER_MAX_EVENTS) {
+    return 1;
+  }
+
+  uint32_t lock = HRTIMER_HAL_Lock();
+
+  if (!events[id].used) {
+    HRTIMER_HAL_Unlock(lock);
+    return 1;
+  }
+
+  events[id].used = 0;
+
+  for (i = 0; i < HRTIMER_HAL_CHANNELS; i++) {
+    if (channelEvent[i] == id) {
+      HRTIMER_HAL_DisableCompare(i);
+      HRTIMER_Refill(i);
+      HRTIMER_HAL_Unlock(lock);
+      return 0;
+    }
+  }
+
+  for (i = 0; i < pendingCount; i++) {
+    if (pending[i] == id) {
+      pendingCount--;
+      for (; i < pendingCount; i++) {
+        pending[i] = pending[i+1];
+      }
+      break;
+    }
+  }
+
+  HRTIMER_HAL_Unlock(lock);
+
+  return 0;
+}
+/**
+ * @brief Callback for compare events from lower layer.
+ * @details Runs in interrupt context.
+ * @param ch Channel which reached its compare value
+ */
+static void HRTIMER_CompareCallback(uint8_t ch) {
+
+  uint32_t lock = HRTIMER_HAL_Lock();
+
+  int8_t id = channelEvent[ch];
+
+  HRTIMER_Refill(ch);
+
+  if (id == HRTIMER_NONE || !events[id].used) {
+    HRTIMER_HAL_Unlock(lock);
+    return;
+  }
+
+  // free the event before calling, so callback can reschedule
+  DEFER_Callback fun = events[id].fun;
+  void* ctx = events[id].ctx;
+  events[id].used = 0;
+
+  HRTIMER_HAL_Unlock(lock);
+
+  fun(ctx);
+}
+
+/**
+ * @}
+ */
@@ -18,91 +18,296 @@
 #include <keys.h>
 #include <timers.h>
 #include <stdio.h>
+#include <log.h>
 #include <keys_hal.h>
+#include <ring.h>
 
 #ifndef DEBUG
   #define DEBUG
 #endif
 
 #ifdef DEBUG
-  #define print(str, args...) printf("KEYS--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("KEYS--> "str"%s",##args,"\r\n")
+  #define print(str, args...) LOG("KEYS--> "str"\r", ##args)
+  #define println(str, args...) LOG("KEYS--> "str"\r\n", ##args)
 #else
   #define print(str, args...) (void)0
   #define println(str, args...) (void)0
 #endif
 
-#define DEBOUNCE_TIME 200 ///< Key debounce time in ms
+#define KEYS_SCAN_PERIOD    5   ///< Time between reads of scan result in ms
+#define KEYS_COUNT          (KEYS_HAL_COLUMNS * KEYS_HAL_ROWS) ///< Number of keys
+#define KEYS_DEBOUNCE_COUNT 4   ///< Integrator limit - samples of a key are KEYS_SCAN_PERIOD apart
+#define KEYS_REPEAT_DELAY   500 ///< Time from press to first repeat in ms
+#define KEYS_REPEAT_PERIOD  100 ///< Time between repeats in ms
+#define KEYS_LONG_TIME      1000 ///< Time from press to long press event in ms
+#define KEYS_EVENTS_LEN     16  ///< Maximum number of waiting events (power of two)
 
 /**
- * Key structure typedef.
+ * @brief Keyboard scanning states.
  */
-typedef struct {
-	uint8_t id;		///< KEY_ID
-	void (*PressCallback)(void);
-	void (*RepeatCallback)(void);
-	uint16_t len;	///<
-	uint16_t count;	///<
-} KEY_TypeDef;
+typedef enum {
+  KEYS_IDLE,  //!< KEYS_IDLE  All columns low, waiting for edge interrupt
+  KEYS_START, //!< KEYS_START Edge detected, scanning has to start
+  KEYS_SCAN,  //!< KEYS_SCAN  Background scan running
+} KEYS_State_TypeDef;
 
+RING_DEFINE(events, KEYS_Event_TypeDef, KEYS_EVENTS_LEN); ///< Events waiting for KEYS_GetEvent
 
+static volatile KEYS_State_TypeDef state; ///< Scanning state
+static uint32_t scanTimer;    ///< Time of last read of scan result
 
-uint8_t currentColumn; ///< Selected keyboard column
+/*
+ * Key bitmaps - bit number is key number (column * KEYS_HAL_ROWS + row).
+ */
+static uint16_t pressed;      ///< Debounced state of keys
+static uint16_t unstable;     ///< Keys with integrator between limits
+static uint16_t longSent;     ///< Held keys that already sent long press event
+
+static uint8_t integrator[KEYS_COUNT]; ///< Debounce integrators (0 - released, KEYS_DEBOUNCE_COUNT - pressed)
+static uint32_t pressTime[KEYS_COUNT]; ///< Time of key press
+static uint32_t repeatTime[KEYS_COUNT]; ///< Time of next repeat event
+static uint32_t deadline;     ///< Earliest timed event of held keys
+
+static uint32_t dropped;      ///< Events lost because queue was full
+
+static void KEYS_EdgeCallback(void);
 
 void KEYS_Init(void) {
 
-  KEYS_HAL_Init();
-  currentColumn = 0;
+  KEYS_HAL_Init(KEYS_EdgeCallback);
 
-  // select first column as default
-  KEYS_HAL_SelectColumn(0);
+  // wait for first key press
+  state = KEYS_IDLE;
+  KEYS_HAL_SelectAllColumns();
+  KEYS_HAL_EnableEdgeIrq();
 
 }
+/**
+ * @brief Called on row edge - a key was pressed.
+ * @details Runs in interrupt context.
+ */
+static void KEYS_EdgeCallback(void) {
 
+  state = KEYS_START;
+}
 /**
- * @brief Checks if any keys are set.
- * @details Run this function in main loop to check for pressed keys.
- * TODO Add repeat, function calling
+ * @brief Stops scanning and waits for edge interrupt.
  */
-uint8_t KEYS_Update(void) {
+static void KEYS_Idle(void) {
+
+  state = KEYS_IDLE;
+  KEYS_HAL_StopScan();
+  KEYS_HAL_SelectAllColumns();
+  KEYS_HAL_EnableEdgeIrq();
+
+  // key pressed before interrupt was enabled
+  if (KEYS_HAL_ReadRows()) {
+    KEYS_HAL_DisableEdgeIrq();
+    state = KEYS_START;
+  }
+}
+/**
+ * @brief Adds event to queue.
+ * @param key Key number
+ * @param type Event type
+ * @param time Time of event
+ */
+static void KEYS_AddEvent(uint8_t key, KEYS_EventType_TypeDef type, uint32_t time) {
+
+  KEYS_Event_TypeDef* event;
+
+  if (RING_Reserve(&events, (void**)&event, 1) == 0) {
+    dropped++;
+    return;
+  }
+
+  event->key = key;
+  event->type = type;
+  event->time = time;
+
+  RING_Commit(&events, 1);
+}
+/**
+ * @brief Returns time of next timed event of a held key.
+ * @param key Key number
+ * @return Time of event
+ */
+static uint32_t KEYS_KeyDeadline(uint8_t key) {
+
+  uint32_t longTime = pressTime[key] + KEYS_LONG_TIME;
+
+  if ((longSent & (1 << key)) || (int32_t)(repeatTime[key] - longTime) < 0) {
+    return repeatTime[key];
+  }
+  return longTime;
+}
+/**
+ * @brief Sends repeat and long press events of held keys.
+ * @details Held keys are only walked when the earliest of
+ * their events is due.
+ * @param now Current time
+ */
+static void KEYS_Timed(uint32_t now) {
+
+  if (!pressed || (int32_t)(now - deadline) < 0) {
+    return;
+  }
 
-  static uint8_t keyId = KEY_NONE;
-  uint8_t keyValid = KEY_NONE; // hold a valid debounced key ID
-  uint8_t currentKey = KEY_NONE;
+  uint16_t held = pressed;
+  uint8_t first = 1;
 
-  static uint32_t debounceTimer = 0; // timer for counting debounce time
+  while (held) {
+    uint8_t key = __builtin_ctz(held);
+    held &= held - 1;
 
-  int8_t row = KEYS_HAL_ReadRow();
+    if (!(longSent & (1 << key)) &&
+        (int32_t)(now - pressTime[key]) >= KEYS_LONG_TIME) {
+      longSent |= 1 << key;
+      KEYS_AddEvent(key, KEYS_LONG, now);
+    }
 
-  // if a keypress has been recongized
-  if (row != -1) {
-    currentKey = (currentColumn << 4) | row;
-//    println("You pressed a key in row %d, column %d.", row, currentColumn);
+    if ((int32_t)(now - repeatTime[key]) >= 0) {
+      KEYS_AddEvent(key, KEYS_REPEAT, now);
+      repeatTime[key] += KEYS_REPEAT_PERIOD;
+      // don't send missed repeats in a burst
+      if ((int32_t)(now - repeatTime[key]) >= 0) {
+        repeatTime[key] = now + KEYS_REPEAT_PERIOD;
+      }
+    }
+
+    uint32_t next = KEYS_KeyDeadline(key);
+    if (first || (int32_t)(next - deadline) < 0) {
+      deadline = next;
+      first = 0;
+    }
   }
+}
+/**
+ * @brief Runs debounce integrator of a key.
+ * @details Integrator counts up while key is sampled pressed,
+ * down while released. State changes only when integrator
+ * reaches a limit.
+ * @param key Key number
+ * @param level Sampled state of key (1 - pressed)
+ * @param now Current time
+ */
+static void KEYS_Integrate(uint8_t key, uint8_t level, uint32_t now) {
 
-  // if key value changed start debounce timer for new key
-  if (keyId != currentKey && currentKey != KEY_NONE) {
-    keyId = currentKey;
-    debounceTimer = TIMER_GetTime();
+  uint16_t bit = 1 << key;
+
+  if (level) {
+    if (integrator[key] < KEYS_DEBOUNCE_COUNT) {
+      integrator[key]++;
+    }
+    if (integrator[key] == KEYS_DEBOUNCE_COUNT && !(pressed & bit)) {
+      pressTime[key] = now;
+      repeatTime[key] = now + KEYS_REPEAT_DELAY;
+      longSent &= ~bit;
+      if (!pressed || (int32_t)(KEYS_KeyDeadline(key) - deadline) < 0) {
+        deadline = KEYS_KeyDeadline(key);
+      }
+      pressed |= bit;
+      KEYS_AddEvent(key, KEYS_PRESS, now);
+    }
+  } else {
+    if (integrator[key] > 0) {
+      integrator[key]--;
+    }
+    if (integrator[key] == 0 && (pressed & bit)) {
+      pressed &= ~bit;
+      KEYS_AddEvent(key, KEYS_RELEASE, now);
+    }
   }
-  // if debounce finished, the key is valid
-  if (keyId != KEY_NONE && TIMER_DelayTimer(DEBOUNCE_TIME, debounceTimer)) {
-    keyValid = keyId;
-    println("You pressed a key 0x%02x.", keyValid);
-    keyId = KEY_NONE;
+
+  if (integrator[key] > 0 && integrator[key] < KEYS_DEBOUNCE_COUNT) {
+    unstable |= bit;
+  } else {
+    unstable &= ~bit;
   }
+}
+/**
+ * @brief Processes result of background scan.
+ * @details Only keys whose sample differs from their debounced
+ * state, or which are still bouncing, are processed - work is
+ * proportional to the number of changed keys.
+ * @param now Current time
+ * @return Bitmap of keys seen pressed
+ */
+static uint16_t KEYS_Sample(uint32_t now) {
 
-  // update column
-  currentColumn++;
+  uint16_t sample = KEYS_HAL_ReadMatrix();
+  uint16_t changed = (sample ^ pressed) | unstable;
 
-  if (currentColumn == 4) {
-    currentColumn = 0;
+  while (changed) {
+    uint8_t key = __builtin_ctz(changed);
+    changed &= changed - 1;
+    KEYS_Integrate(key, (sample >> key) & 1, now);
   }
 
-  KEYS_HAL_SelectColumn(currentColumn);
+  return sample;
+}
+
+/**
+ * @brief Scans the keyboard.
+ * @details Run this function in main loop. After a key press is
+ * signaled by an edge interrupt, the keyboard is scanned in the
+ * background by DMA and the result is read every KEYS_SCAN_PERIOD,
+ * until all keys are released. Otherwise the function returns
+ * immediately. Press, release, repeat and long press events are
+ * read with KEYS_GetEvent.
+ */
+void KEYS_Update(void) {
+
+  uint32_t now = TIMER_GetTime();
+
+  switch (state) {
+  case KEYS_IDLE:
+    return;
 
-  // if key is valid return ID, if not returns KEY_NONE
-  return keyValid;
+  case KEYS_START:
+    KEYS_HAL_StartScan();
+    scanTimer = now;
+    state = KEYS_SCAN;
+    return;
+
+  case KEYS_SCAN:
+    KEYS_Timed(now);
+    // wait for the next full scan
+    if (!TIMER_DelayTimer(KEYS_SCAN_PERIOD, scanTimer)) {
+      return;
+    }
+    scanTimer = now;
+    break;
+  }
+
+  // all keys released - stop scanning
+  if (!KEYS_Sample(now) && !pressed && !unstable) {
+    KEYS_Idle();
+  }
+}
+/**
+ * @brief Gets keyboard event.
+ * @param event Event read from queue
+ * @retval 0 Got event
+ * @retval 1 No events waiting
+ */
+uint8_t KEYS_GetEvent(KEYS_Event_TypeDef* event) {
+
+  return RING_Pop(&events, event);
 }
+/**
+ * @brief Returns debounced state of keys.
+ * @return Bitmap of pressed keys (bit number is key number)
+ */
+uint16_t KEYS_GetState(void) {
 
+  return pressed;
+}
+/**
+ * @brief Returns number of events lost because queue was full.
+ * @return Number of dropped events
+ */
+uint32_t KEYS_GetDropped(void) {
 
+  return dropped;
+}
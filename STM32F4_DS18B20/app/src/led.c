@@ -25,16 +25,18 @@
  */
 
 #include <stdio.h>
+#include <log.h>
 #include <led.h>
 #include <led_hal.h>
+#include <critical.h>
 
 #ifndef DEBUG
   #define DEBUG
 #endif
 
 #ifdef DEBUG
-  #define print(str, args...) printf("LED--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("LED--> "str"%s",##args,"\r\n")
+  #define print(str, args...) LOG("LED--> "str"\r", ##args)
+  #define println(str, args...) LOG("LED--> "str"\r\n", ##args)
 #else
   #define print(str, args...) (void)0
   #define println(str, args...) (void)0
@@ -45,7 +47,8 @@
  * @{
  */
 
-static LED_State_TypeDef ledState[MAX_LEDS]; ///< States of the LEDs (MAX_LEDS is hardware dependent)
+static uint32_t ledUsed; ///< Bitmap of initialized LEDs
+static uint32_t ledOn;   ///< Bitmap of lit LEDs (state shadow)
 
 /**
  * @brief Add an LED.
@@ -60,7 +63,32 @@ void LED_Init(LED_Number_TypeDef led) {
   }
 
   LED_HAL_Init(led);
-  ledState[led] = LED_OFF; // LED initially off
+  ledUsed |= LED_MASK(led);
+  LED_Update(0, LED_MASK(led), 0); // LED initially off
+}
+
+/**
+ * @brief Change state of many LEDs at once.
+ * @details New state is ((state | set) & ~clear) ^ toggle.
+ * Changed pins are written with one BSRR write per port and the
+ * shadow with one store, both with interrupts disabled, so pins
+ * follow the shadow even when called from interrupts. Bits of
+ * uninitialized LEDs are ignored.
+ * @param set Bitmap of LEDs to light up (LED_MASK)
+ * @param clear Bitmap of LEDs to turn off
+ * @param toggle Bitmap of LEDs to toggle
+ */
+void LED_Update(uint32_t set, uint32_t clear, uint32_t toggle) {
+
+  uint32_t lock = CRITICAL_Enter();
+
+  uint32_t state = (((ledOn | set) & ~clear) ^ toggle) & ledUsed;
+  uint32_t changed = state ^ ledOn;
+
+  LED_HAL_Write(state & changed, ~state & changed);
+  ledOn = state;
+
+  CRITICAL_Exit(lock);
 }
 
 /**
@@ -75,18 +103,16 @@ void LED_ChangeState(LED_Number_TypeDef led, LED_State_TypeDef state) {
     return;
   }
 
-  if (ledState[led] == LED_UNUSED) {
+  if (!(ledUsed & LED_MASK(led))) {
     println("Error: Uninitialized LED %d!", (int)led);
     return;
-  } else {
-    if (state == LED_OFF) {
-      LED_HAL_ChangeState(led, 0); // turn off LED
-    } else if (state == LED_ON) {
-      LED_HAL_ChangeState(led, 1); // light up LED
-    }
   }
 
-  ledState[led] = state; // update LED state
+  if (state == LED_OFF) {
+    LED_Update(0, LED_MASK(led), 0); // turn off LED
+  } else if (state == LED_ON) {
+    LED_Update(LED_MASK(led), 0, 0); // light up LED
+  }
 }
 
 /**
@@ -100,17 +126,12 @@ void LED_Toggle(LED_Number_TypeDef led) {
     return;
   }
 
-  if (ledState[led] == LED_UNUSED) {
+  if (!(ledUsed & LED_MASK(led))) {
     println("Error: Uninitialized LED %d!", (int)led);
     return;
-  } else {
-    if (ledState[led] == LED_OFF) {
-      ledState[led] = LED_ON;
-    } else if (ledState[led] == LED_ON) {
-      ledState[led]= LED_OFF;
-    }
-    LED_HAL_Toggle(led);
   }
+
+  LED_Update(0, 0, LED_MASK(led));
 }
 
 /**
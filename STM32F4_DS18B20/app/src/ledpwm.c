@@ -0,0 +1,229 @@
+/**
+ * @file:   ledpwm.c
+ * @brief:  LED brightness and pattern engine
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <stdio.h>
+#include <log.h>
+#include <ledpwm.h>
+#include <ledpwm_hal.h>
+#include <critical.h>
+
+#ifndef DEBUG
+  #define DEBUG
+#endif
+
+#ifdef DEBUG
+  #define print(str, args...) LOG("LEDPWM--> "str"\r", ##args)
+  #define println(str, args...) LOG("LEDPWM--> "str"\r\n", ##args)
+#else
+  #define print(str, args...) (void)0
+  #define println(str, args...) (void)0
+#endif
+
+/**
+ * @addtogroup LEDPWM
+ * @{
+ */
+
+/**
+ * @brief State of a PWM channel.
+ */
+typedef struct {
+  const LEDPWM_Step_TypeDef* steps; ///< Pattern played (NULL - constant level)
+  uint8_t len;      ///< Number of steps in pattern
+  uint8_t loop;     ///< Nonzero - pattern is repeated
+  uint8_t index;    ///< Current step
+  uint8_t from;     ///< Level at start of current step
+  uint8_t level;    ///< Current level
+  uint16_t elapsed; ///< Time since start of current step in ms
+  LEDPWM_Step_TypeDef blink[2]; ///< Steps of LEDPWM_Blink pattern
+} LEDPWM_Channel_TypeDef;
+
+static LEDPWM_Channel_TypeDef channels[LEDPWM_HAL_CHANNELS]; ///< Channel states
+static uint8_t initialized; ///< Nonzero - timer is running
+
+static void LEDPWM_Fill(uint16_t* frames, uint16_t count);
+
+/**
+ * @brief Drive an LED with PWM.
+ * @details The LED starts off. It can't be used with
+ * LED_ChangeState and LED_Toggle afterwards.
+ * @param led LED number
+ */
+void LEDPWM_Init(LED_Number_TypeDef led) {
+
+  if (led >= LEDPWM_HAL_CHANNELS) {
+    println("Error: Incorrect LED number %d!", (int)led);
+    return;
+  }
+
+  if (!initialized) {
+    LEDPWM_HAL_Init(LEDPWM_Fill);
+    initialized = 1;
+  }
+
+  LEDPWM_HAL_EnableOutput(led);
+}
+/**
+ * @brief Calculates level for next frame and advances the pattern.
+ * @param ch Channel
+ * @return Level
+ */
+static uint8_t LEDPWM_Next(LEDPWM_Channel_TypeDef* ch) {
+
+  if (!ch->steps) {
+    return ch->level;
+  }
+
+  const LEDPWM_Step_TypeDef* step = &ch->steps[ch->index];
+
+  if (step->fade && step->time) {
+    ch->level = ch->from + ((int32_t)step->level - ch->from) * ch->elapsed / step->time;
+  } else {
+    ch->level = step->level;
+  }
+
+  ch->elapsed += LEDPWM_HAL_FRAME_TIME;
+
+  // step finished
+  if (ch->elapsed >= step->time) {
+    ch->from = step->level;
+    ch->elapsed = 0;
+    ch->index++;
+
+    if (ch->index == ch->len) {
+      if (ch->loop) {
+        ch->index = 0;
+      } else {
+        ch->level = ch->from; // hold last level
+        ch->steps = NULL;
+      }
+    }
+  }
+
+  return ch->level;
+}
+/**
+ * @brief Fills frames of compare table.
+ * @details Called by HAL (in interrupt) for each half of the
+ * table that has been sent.
+ * @param frames First frame
+ * @param count Number of frames
+ */
+static void LEDPWM_Fill(uint16_t* frames, uint16_t count) {
+
+  uint16_t i;
+  uint8_t j;
+
+  for (i = 0; i < count; i++) {
+    for (j = 0; j < LEDPWM_HAL_CHANNELS; j++) {
+      *frames++ = LEDPWM_Next(&channels[j]);
+    }
+  }
+}
+/**
+ * @brief Play a pattern on an LED.
+ * @details Steps are played by the timer, the pattern has to
+ * stay valid while playing. The change is visible after the
+ * frames already in the compare table, i.e. within
+ * 2 * LEDPWM_HAL_FRAMES * LEDPWM_HAL_FRAME_TIME ms.
+ * @param led LED number
+ * @param steps Pattern steps (NULL - keep current level)
+ * @param len Number of steps
+ * @param loop Nonzero - repeat pattern, zero - hold last level
+ */
+void LEDPWM_Play(LED_Number_TypeDef led, const LEDPWM_Step_TypeDef* steps,
+    uint8_t len, uint8_t loop) {
+
+  if (led >= LEDPWM_HAL_CHANNELS) {
+    println("Error: Incorrect LED number %d!", (int)led);
+    return;
+  }
+
+  LEDPWM_Channel_TypeDef* ch = &channels[led];
+
+  uint32_t lock = CRITICAL_Enter();
+
+  ch->steps = len ? steps : NULL;
+  ch->len = len;
+  ch->loop = loop;
+  ch->index = 0;
+  ch->elapsed = 0;
+  ch->from = ch->level;
+
+  CRITICAL_Exit(lock);
+}
+/**
+ * @brief Set constant brightness of an LED.
+ * @param led LED number
+ * @param level Brightness (0 - LEDPWM_MAX_LEVEL)
+ */
+void LEDPWM_SetLevel(LED_Number_TypeDef led, uint8_t level) {
+
+  if (led >= LEDPWM_HAL_CHANNELS) {
+    println("Error: Incorrect LED number %d!", (int)led);
+    return;
+  }
+
+  uint32_t lock = CRITICAL_Enter();
+
+  channels[led].steps = NULL;
+  channels[led].level = level;
+
+  CRITICAL_Exit(lock);
+}
+/**
+ * @brief Blink an LED.
+ * @param led LED number
+ * @param level Brightness when on
+ * @param onTime Time on in ms
+ * @param offTime Time off in ms
+ */
+void LEDPWM_Blink(LED_Number_TypeDef led, uint8_t level, uint16_t onTime, uint16_t offTime) {
+
+  if (led >= LEDPWM_HAL_CHANNELS) {
+    println("Error: Incorrect LED number %d!", (int)led);
+    return;
+  }
+
+  LEDPWM_Channel_TypeDef* ch = &channels[led];
+
+  // stop pattern before changing its steps
+  LEDPWM_Play(led, NULL, 0, 0);
+
+  ch->blink[0].level = level;
+  ch->blink[0].fade = 0;
+  ch->blink[0].time = onTime;
+  ch->blink[1].level = 0;
+  ch->blink[1].fade = 0;
+  ch->blink[1].time = offTime;
+
+  LEDPWM_Play(led, ch->blink, 2, 1);
+}
+/**
+ * @brief Updates PWM frequency after clock change.
+ * @details Call after changing APB1 clock.
+ */
+void LEDPWM_ClockChanged(void) {
+
+  if (initialized) {
+    LEDPWM_HAL_UpdateClock();
+  }
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,284 @@
+/**
+ * @file:   log.c
+ * @brief:  Deferred binary logging
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @details Recording a log message only copies the address of its
+ * format string, a timestamp and the raw arguments into a ring
+ * buffer. This is cheap enough for interrupts and hot paths.
+ * The main loop calls LOG_Flush, which either formats the messages
+ * as text (telemetry text mode) or sends the records in binary
+ * telemetry frames (binary mode). In binary mode the host looks up
+ * the format strings in the firmware ELF file and does the formatting
+ * (see tools/telemetry.py).
+ *
+ * A record looks like this (little endian):
+ *
+ * @verbatim
+ * | nargs (1) | format address (4) | time in ms (4) | args (4 * nargs) | string |
+ * @endverbatim
+ *
+ * Bit 7 of nargs is set in records of LOG_STR. The first argument
+ * is then the length of the string copied to the end of the record.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <log.h>
+#include <fifo.h>
+#include <timers.h>
+#include <telemetry.h>
+#include <comm.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+// HAL
+#include <critical.h>
+
+/**
+ * @addtogroup LOG
+ * @{
+ */
+
+#define LOG_BUF_LEN     1024  ///< Length of record buffer (power of two)
+#define LOG_HEADER_LEN  9     ///< Length of record without arguments
+#define LOG_FLAG_STR    0x80  ///< Record carries a copied string
+#define LOG_NARGS_MASK  0x7f  ///< Number of arguments in first byte of record
+#define LOG_MAX_LINE    160   ///< Maximum length of formatted message
+#define LOG_FLUSH_MAX   8     ///< Maximum number of messages formatted by one flush
+
+static uint8_t logBuffer[LOG_BUF_LEN];  ///< Buffer for records
+static FIFO_TypeDef logFifo;            ///< Record FIFO
+static volatile uint32_t dropped;       ///< Number of records dropped due to full buffer
+
+/**
+ * @brief Initialize logging.
+ */
+void LOG_Init(void) {
+
+  logFifo.buf = logBuffer;
+  logFifo.len = LOG_BUF_LEN;
+  FIFO_Add(&logFifo);
+}
+/**
+ * @brief Writes a record into the buffer.
+ * @param fmt Format string (has to be constant)
+ * @param str String copied into the record (NULL - none)
+ * @param nargs Number of arguments
+ * @param ap Arguments
+ */
+static void LOG_Write(const char* fmt, const char* str, unsigned int nargs, va_list ap) {
+
+  uint8_t record[LOG_MAX_RECORD];
+  uint32_t val;
+  uint32_t strLen = 0;
+  uint8_t i = 0;
+
+  if (str) {
+    nargs++; // string length goes first
+  }
+  if (nargs > LOG_MAX_ARGS) {
+    nargs = LOG_MAX_ARGS; // extra arguments are lost
+  }
+
+  record[0] = nargs | (str ? LOG_FLAG_STR : 0);
+  val = (uint32_t)fmt;
+  memcpy(&record[1], &val, 4);
+  val = TIMER_GetTime();
+  memcpy(&record[5], &val, 4);
+
+  if (str) {
+    strLen = strnlen(str, LOG_MAX_STR);
+    memcpy(&record[LOG_HEADER_LEN], &strLen, 4);
+    i = 1;
+  }
+
+  for (; i < nargs; i++) {
+    val = va_arg(ap, uint32_t);
+    memcpy(&record[LOG_HEADER_LEN + 4 * i], &val, 4);
+  }
+
+  uint16_t len = LOG_HEADER_LEN + 4 * nargs;
+  memcpy(&record[len], str, strLen);
+  len += strLen;
+
+  // producers in interrupts - whole record has to go in at once
+  uint32_t lock = CRITICAL_Enter();
+
+  if (FIFO_GetFree(&logFifo) >= len) {
+    FIFO_PushBuf(&logFifo, record, len);
+  } else {
+    dropped++;
+  }
+
+  CRITICAL_Exit(lock);
+}
+/**
+ * @brief Records a log message.
+ * @details Use the LOG macro, which counts the arguments.
+ * Can be called from interrupts.
+ * @param fmt Format string (has to be constant)
+ * @param nargs Number of arguments
+ */
+void LOG_Record(const char* fmt, unsigned int nargs, ...) {
+
+  va_list ap;
+
+  va_start(ap, nargs);
+  LOG_Write(fmt, NULL, nargs, ap);
+  va_end(ap);
+}
+/**
+ * @brief Records a log message with a copy of a string.
+ * @details Use the LOG_STR macro, which counts the arguments.
+ * Can be called from interrupts.
+ * @param fmt Format string (has to be constant)
+ * @param str String copied into the record
+ * @param nargs Number of arguments following the string
+ */
+void LOG_RecordStr(const char* fmt, const char* str, unsigned int nargs, ...) {
+
+  va_list ap;
+
+  va_start(ap, nargs);
+  LOG_Write(fmt, str, nargs, ap);
+  va_end(ap);
+}
+/**
+ * @brief Get length of a record.
+ * @param offset Offset of record from the tail of buffer
+ * @return Record length (0 - no record)
+ */
+static uint16_t LOG_GetRecordLen(uint16_t offset) {
+
+  uint8_t nargs;
+  uint32_t strLen = 0;
+
+  if (FIFO_PeekBuf(&logFifo, offset, &nargs, 1) == 0) {
+    return 0;
+  }
+
+  if (nargs & LOG_FLAG_STR) {
+    FIFO_PeekBuf(&logFifo, offset + LOG_HEADER_LEN, (uint8_t*)&strLen, 4);
+  }
+
+  return LOG_HEADER_LEN + 4 * (nargs & LOG_NARGS_MASK) + strLen;
+}
+/**
+ * @brief Formats the oldest record and sends it as a line of text.
+ * @param len Record length
+ * @retval 0 Record sent and removed
+ * @retval 1 No room in TX buffer - record waits
+ */
+static uint8_t LOG_PrintRecord(uint16_t len) {
+
+  uint8_t record[LOG_MAX_RECORD];
+  uint32_t args[LOG_MAX_ARGS] = {0};
+  char str[LOG_MAX_STR + 1];
+  char line[LOG_MAX_LINE];
+  const char* fmt;
+
+  if (COMM_GetTxFree() < LOG_MAX_LINE) {
+    return 1;
+  }
+
+  FIFO_PeekBuf(&logFifo, 0, record, len);
+
+  uint8_t nargs = record[0] & LOG_NARGS_MASK;
+  memcpy(&fmt, &record[1], 4);
+  memcpy(args, &record[LOG_HEADER_LEN], 4 * nargs);
+
+  if (record[0] & LOG_FLAG_STR) { // copied string replaces its length
+    memcpy(str, &record[LOG_HEADER_LEN + 4 * nargs], args[0]);
+    str[args[0]] = '\0';
+    args[0] = (uint32_t)str;
+  }
+
+  int n = snprintf(line, LOG_MAX_LINE, fmt, args[0], args[1], args[2],
+      args[3], args[4], args[5]);
+
+  if (n >= LOG_MAX_LINE) { // truncated
+    n = LOG_MAX_LINE - 1;
+  }
+  if (n > 0) {
+    COMM_Write((uint8_t*)line, n);
+  }
+
+  FIFO_Discard(&logFifo, len);
+
+  return 0;
+}
+/**
+ * @brief Sends recorded messages.
+ * @details This function should be called periodically in the main
+ * loop of the program. In text mode at most LOG_FLUSH_MAX messages
+ * are formatted in one call. Messages which don't fit into TX buffer
+ * wait for the next call in both modes - in binary mode records are
+ * copied into a frame and removed only after the frame was accepted
+ * for sending.
+ */
+void LOG_Flush(void) {
+
+  uint8_t payload[TELEM_MAX_PAYLOAD];
+  uint16_t payloadLen = 0; // also number of bytes of records in payload
+  uint16_t len;
+  uint8_t i;
+
+  if (TELEM_GetMode() == TELEM_MODE_TEXT) {
+
+    for (i = 0; i < LOG_FLUSH_MAX && (len = LOG_GetRecordLen(0)) != 0; i++) {
+      if (LOG_PrintRecord(len)) {
+        return;
+      }
+    }
+    return;
+  }
+
+  while ((len = LOG_GetRecordLen(payloadLen)) != 0) {
+
+    // send full frame and start next one
+    if (payloadLen + len > TELEM_MAX_PAYLOAD) {
+      if (TELEM_SendFrame(TELEM_TYPE_LOG, payload, payloadLen)) {
+        return; // no room in TX buffer - records wait for next flush
+      }
+      FIFO_Discard(&logFifo, payloadLen);
+      payloadLen = 0;
+    }
+    FIFO_PeekBuf(&logFifo, payloadLen, &payload[payloadLen], len);
+    payloadLen += len;
+  }
+
+  if (payloadLen && !TELEM_SendFrame(TELEM_TYPE_LOG, payload, payloadLen)) {
+    FIFO_Discard(&logFifo, payloadLen);
+  }
+}
+/**
+ * @brief Get free space in record buffer.
+ * @details Compare with LOG_MAX_RECORD to check if a message fits.
+ * @return Number of free bytes
+ */
+uint16_t LOG_GetFree(void) {
+
+  return FIFO_GetFree(&logFifo);
+}
+/**
+ * @brief Get number of records dropped because buffer was full.
+ * @return Number of dropped records
+ */
+uint32_t LOG_GetDropped(void) {
+
+  return dropped;
+}
+
+/**
+ * @}
+ */
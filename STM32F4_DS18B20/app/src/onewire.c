@@ -23,13 +23,14 @@
 #include <onewire_hal.h>
 #include <timers.h>
 #include <stdio.h>
+#include <log.h>
 
 
 #define DEBUG
 
 #ifdef DEBUG
-#define print(str, args...) printf("1WIRE--> "str"%s",##args,"")
-#define println(str, args...) printf("1WIRE--> "str"%s",##args,"\r\n")
+#define print(str, args...) LOG("1WIRE--> "str, ##args)
+#define println(str, args...) LOG("1WIRE--> "str"\r\n", ##args)
 #else
 #define print(str, args...) (void)0
 #define println(str, args...) (void)0
@@ -0,0 +1,279 @@
+/**
+ * @file:   ring.c
+ * @brief:  Ring buffer of fixed size records
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <ring.h>
+#include <string.h>
+
+/**
+ * @addtogroup RING
+ * @{
+ */
+
+/**
+ * @brief Memory barrier - data accesses complete before index update.
+ */
+#define RING_BARRIER() __sync_synchronize()
+
+/**
+ * @brief Add a ring.
+ * @details Rings not defined with RING_DEFINE (e.g. arrays of
+ * rings) need a RING_TypeDef structure initialized with the
+ * buffer pointer, record size and length. The rest is handled
+ * automatically.
+ * @param ring Pointer to ring structure
+ * @retval 0 Ring added successfully
+ * @retval 1 Error: ring length is 0 or not a power of two
+ */
+uint8_t RING_Add(RING_TypeDef* ring) {
+
+  if (ring->len == 0 || (ring->len & (ring->len - 1))) {
+    return 1;
+  }
+
+  ring->head  = 0;
+  ring->tail  = 0;
+  ring->mask  = ring->len - 1;
+
+  return 0;
+}
+
+/**
+ * @brief Reserve contiguous free records.
+ * @details Records are written in place and published with
+ * RING_Commit. Call only from the producer side.
+ * @param ring Pointer to ring structure
+ * @param rec Pointer to first free record
+ * @param max Maximum number of records needed
+ * @return Number of records reserved (0 - ring is full)
+ */
+uint16_t RING_Reserve(RING_TypeDef* ring, void** rec, uint16_t max) {
+
+  uint32_t head = ring->head;
+  uint16_t free = ring->len - (head - ring->tail);
+  uint16_t start = head & ring->mask;
+
+  // span ends at the end of buffer
+  if (free > ring->len - start) {
+    free = ring->len - start;
+  }
+  if (free > max) {
+    free = max;
+  }
+
+  RING_BARRIER(); // consumer finished reading freed records
+  *rec = &ring->buf[start * ring->size];
+
+  return free;
+}
+/**
+ * @brief Publish reserved records.
+ * @details Call only from the producer side.
+ * @param ring Pointer to ring structure
+ * @param n Number of records written (not more than reserved)
+ */
+void RING_Commit(RING_TypeDef* ring, uint16_t n) {
+
+  RING_BARRIER();
+  ring->head += n; // publish data
+}
+/**
+ * @brief Get contiguous records at the tail of ring.
+ * @details Records are not removed - use RING_Consume after
+ * they have been processed (e.g. sent by DMA).
+ * Call only from the consumer side.
+ * @param ring Pointer to ring structure
+ * @param rec Pointer to first record
+ * @param max Maximum number of records needed
+ * @return Number of records in span (0 - ring is empty)
+ */
+uint16_t RING_Peek(RING_TypeDef* ring, void** rec, uint16_t max) {
+
+  uint32_t tail = ring->tail;
+  uint16_t count = ring->head - tail;
+  uint16_t start = tail & ring->mask;
+
+  // span ends at the end of buffer
+  if (count > ring->len - start) {
+    count = ring->len - start;
+  }
+  if (count > max) {
+    count = max;
+  }
+
+  RING_BARRIER();
+  *rec = &ring->buf[start * ring->size];
+
+  return count;
+}
+/**
+ * @brief Removes records from the tail of ring.
+ * @details Call only from the consumer side.
+ * @param ring Pointer to ring structure
+ * @param n Number of records to remove
+ */
+void RING_Consume(RING_TypeDef* ring, uint16_t n) {
+
+  uint32_t tail = ring->tail;
+  uint16_t count = ring->head - tail;
+
+  if (n > count) {
+    n = count;
+  }
+
+  RING_BARRIER();
+  ring->tail = tail + n; // free space
+}
+/**
+ * @brief Pushes a record to ring.
+ * @details The record is copied with one memcpy.
+ * Call only from the producer side.
+ * @param ring Pointer to ring structure
+ * @param rec Record
+ * @retval 0 Record added
+ * @retval 1 Error: ring is full
+ */
+uint8_t RING_Push(RING_TypeDef* ring, const void* rec) {
+
+  void* dst;
+
+  if (RING_Reserve(ring, &dst, 1) == 0) {
+    return 1;
+  }
+
+  memcpy(dst, rec, ring->size);
+  RING_Commit(ring, 1);
+
+  return 0;
+}
+/**
+ * @brief Pops a record from ring.
+ * @details The record is copied with one memcpy.
+ * Call only from the consumer side.
+ * @param ring Pointer to ring structure
+ * @param rec Buffer for record
+ * @retval 0 Got valid record
+ * @retval 1 Error: ring is empty
+ */
+uint8_t RING_Pop(RING_TypeDef* ring, void* rec) {
+
+  void* src;
+
+  if (RING_Peek(ring, &src, 1) == 0) {
+    return 1;
+  }
+
+  memcpy(rec, src, ring->size);
+  RING_Consume(ring, 1);
+
+  return 0;
+}
+/**
+ * @brief Get number of records in ring.
+ * @param ring Pointer to ring structure
+ * @return Number of records which can be popped
+ */
+uint16_t RING_GetCount(RING_TypeDef* ring) {
+
+  return ring->head - ring->tail;
+}
+/**
+ * @brief Get free space in ring.
+ * @param ring Pointer to ring structure
+ * @return Number of records which can be pushed
+ */
+uint16_t RING_GetFree(RING_TypeDef* ring) {
+
+  return ring->len - (ring->head - ring->tail);
+}
+/**
+ * @brief Pushes a record overwriting the oldest one if ring is full.
+ * @details The record gets the sequence number equal to the head
+ * before the push. Call only from the producer side.
+ * @param ring Pointer to ring structure
+ * @param rec Record
+ */
+void RING_PushOverwrite(RING_TypeDef* ring, const void* rec) {
+
+  uint32_t head = ring->head;
+
+  ring->tail = head + 1; // readers of overwritten record retry
+  RING_BARRIER();
+
+  memcpy(&ring->buf[(head & ring->mask) * ring->size], rec, ring->size);
+
+  RING_BARRIER();
+  ring->head = head + 1; // publish data
+}
+/**
+ * @brief Reads records written since a sequence number.
+ * @details Use on rings written with RING_PushOverwrite. If the
+ * requested records were already overwritten, reading starts from
+ * the oldest record kept. Records are copied with at most two
+ * memcpy calls - the copy is repeated if the producer overwrote
+ * them in the meantime.
+ * @param ring Pointer to ring structure
+ * @param seq Sequence number of first record needed, returns
+ * sequence number of first record read
+ * @param buf Buffer for records
+ * @param max Maximum number of records
+ * @return Number of records read
+ */
+uint16_t RING_ReadSince(RING_TypeDef* ring, uint32_t* seq, void* buf, uint16_t max) {
+
+  uint32_t head;
+  uint32_t first;
+  uint32_t count;
+
+  do {
+    head = ring->head;
+    count = head - *seq;
+
+    if ((int32_t)count <= 0) { // nothing new
+      return 0;
+    }
+    if (count > ring->len) { // older records overwritten
+      count = ring->len;
+    }
+    first = head - count;
+    if (count > max) {
+      count = max;
+    }
+
+    RING_BARRIER();
+
+    // first part up to the end of buffer
+    uint16_t start = first & ring->mask;
+    uint16_t part = ring->len - start;
+    if (part > count) {
+      part = count;
+    }
+
+    memcpy(buf, &ring->buf[start * ring->size], part * ring->size);
+    memcpy((uint8_t*)buf + part * ring->size, ring->buf, (count - part) * ring->size);
+
+    RING_BARRIER();
+
+  } while (ring->tail - first > ring->len); // first record was overwritten
+
+  *seq = first;
+
+  return count;
+}
+
+/**
+ * @}
+ */
@@ -29,8 +29,16 @@ void _close() {
 
 }
 
-void _isatty() {
+/**
+ * @brief Tells newlib every file is a terminal.
+ * @details This makes stdout line buffered, so printf
+ * passes whole lines to _write.
+ * @param fileHandle
+ * @return Always 1
+ */
+int _isatty(int fileHandle) {
 
+  return 1;
 }
 
 void _lseek() {
@@ -64,10 +72,8 @@ int _read(int fileHandle, char *buf, int len) {
  */
 int _write(int fileHandle, char *buf, int len) {
 
-	int i;
-	for (i=0; i<len; i++) {
-		COMM_Putc((uint8_t)buf[i]);
-	}
+	// whole buffer goes to COMM in one call
+	COMM_Write((uint8_t*)buf, (uint16_t)len);
 
 	return len;
 }
@@ -0,0 +1,363 @@
+/**
+ * @file:   telemetry.c
+ * @brief:  Sensor telemetry protocol
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @details Samples are sent either as text lines or as binary
+ * frames. A binary frame before encoding looks like this:
+ *
+ * @verbatim
+ * | type (1) | sequence (2) | payload (n) | CRC-32 (4) |
+ * @endverbatim
+ *
+ * Multibyte fields are little endian. The CRC covers all
+ * previous bytes of the frame and is calculated by the hardware
+ * CRC unit (see crc_hal.c for the exact algorithm). The frame is
+ * then COBS encoded and terminated with a zero byte, so the host
+ * can resynchronize on any zero.
+ *
+ * A sample payload is a batch of TELEM_Sample_TypeDef records.
+ * A log payload is a sequence of records described in log.c.
+ * Samples are collected in a ring until a batch is full or the
+ * oldest sample gets too old, and are sent straight from the ring.
+ *
+ * Newest samples of every sensor are also kept in a history ring,
+ * which overwrites the oldest ones. Each sample gets a sequence
+ * number, so after reconnecting the host can fetch everything
+ * since the last sample it got with TELEM_SendHistory. A history
+ * payload is the sensor number, the sequence number of the first
+ * sample (LE32) and the samples.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <telemetry.h>
+#include <comm.h>
+#include <ring.h>
+#include <timers.h>
+#include <log.h>
+#include <string.h>
+// HAL
+#include <crc_hal.h>
+
+#ifndef DEBUG
+  #define DEBUG
+#endif
+
+#ifdef DEBUG
+  #define print(str, args...) LOG("TELEM--> "str"\r", ##args)
+  #define println(str, args...) LOG("TELEM--> "str"\r\n", ##args)
+#else
+  #define print(str, args...) (void)0
+  #define println(str, args...) (void)0
+#endif
+
+/**
+ * @addtogroup TELEM
+ * @{
+ */
+
+#define TELEM_BATCH_LEN     8     ///< Maximum number of samples in one frame
+#define TELEM_RING_LEN      32    ///< Maximum number of waiting samples (power of two)
+#define TELEM_HISTORY_LEN   64    ///< Number of samples kept per sensor (power of two)
+#define TELEM_HISTORY_HEADER 5    ///< Sensor number and sequence number of first sample
+#define TELEM_HISTORY_BATCH ((TELEM_MAX_PAYLOAD - TELEM_HISTORY_HEADER) / sizeof(TELEM_Sample_TypeDef)) ///< Samples in history frame
+#define TELEM_MAX_AGE       1000  ///< Maximum time a sample waits in batch in ms
+#define TELEM_HEADER_LEN    3     ///< Type and sequence number
+#define TELEM_CRC_LEN       4     ///< CRC-32 trailer
+#define TELEM_MAX_FRAME     (TELEM_HEADER_LEN + TELEM_MAX_PAYLOAD + TELEM_CRC_LEN) ///< Maximum frame length
+
+static TELEM_Mode_TypeDef mode; ///< Current output mode
+static uint16_t sequence;       ///< Sequence number of next frame
+
+RING_DEFINE(samples, TELEM_Sample_TypeDef, TELEM_RING_LEN); ///< Samples waiting to be sent
+
+static TELEM_Sample_TypeDef historyBuffer[TELEM_MAX_SENSORS][TELEM_HISTORY_LEN]; ///< Buffers for sample history
+static RING_TypeDef history[TELEM_MAX_SENSORS]; ///< Newest samples of sensors
+
+/**
+ * @brief Initialize telemetry.
+ * @param m Output mode
+ */
+void TELEM_Init(TELEM_Mode_TypeDef m) {
+
+  CRC_HAL_Init();
+
+  mode = m;
+  sequence = 0;
+  RING_Consume(&samples, RING_GetCount(&samples));
+
+  uint8_t i;
+  for (i = 0; i < TELEM_MAX_SENSORS; i++) {
+    history[i].buf  = (uint8_t*)historyBuffer[i];
+    history[i].size = sizeof(TELEM_Sample_TypeDef);
+    history[i].len  = TELEM_HISTORY_LEN;
+    RING_Add(&history[i]);
+  }
+}
+/**
+ * @brief Change output mode.
+ * @details Samples waiting in ring are sent first (samples
+ * which can't be sent are dropped).
+ * @param m New output mode
+ */
+void TELEM_SetMode(TELEM_Mode_TypeDef m) {
+
+  TELEM_Flush();
+  RING_Consume(&samples, RING_GetCount(&samples));
+  mode = m;
+}
+/**
+ * @brief Get current output mode.
+ * @return Output mode
+ */
+TELEM_Mode_TypeDef TELEM_GetMode(void) {
+
+  return mode;
+}
+/**
+ * @brief Get pointer to byte of output spans.
+ * @param out Two output spans
+ * @param idx Byte index
+ * @return Pointer to byte
+ */
+static inline uint8_t* TELEM_SpanAt(FIFO_Span_TypeDef* out, uint16_t idx) {
+
+  if (idx < out[0].len) {
+    return &out[0].buf[idx];
+  }
+
+  return &out[1].buf[idx - out[0].len];
+}
+/**
+ * @brief COBS encode data.
+ * @param in Data
+ * @param len Number of bytes
+ * @param out Two spans for encoded data (at least len + len/254 + 1 bytes)
+ * @return Length of encoded data (without terminator)
+ */
+static uint16_t TELEM_CobsEncode(const uint8_t* in, uint16_t len, FIFO_Span_TypeDef* out) {
+
+  uint16_t codeIdx = 0; // where the current block length goes
+  uint16_t outIdx = 1;
+  uint8_t code = 1;
+
+  while (len--) {
+
+    if (*in) {
+      *TELEM_SpanAt(out, outIdx++) = *in;
+      code++;
+    }
+
+    // end of block on zero or maximum block length
+    if (*in == 0 || code == 0xff) {
+      *TELEM_SpanAt(out, codeIdx) = code;
+      codeIdx = outIdx++;
+      code = 1;
+    }
+    in++;
+  }
+
+  *TELEM_SpanAt(out, codeIdx) = code;
+
+  return outIdx;
+}
+/**
+ * @brief Send a binary frame.
+ * @details The frame is encoded straight into the TX buffer.
+ * @param type Frame type
+ * @param payload Frame payload
+ * @param len Payload length
+ * @retval 0 Frame sent
+ * @retval 1 Error: payload too long or no room in TX buffer
+ */
+uint8_t TELEM_SendFrame(uint8_t type, const uint8_t* payload, uint16_t len) {
+
+  uint8_t frame[TELEM_MAX_FRAME];
+  FIFO_Span_TypeDef out[2];
+
+  if (len > TELEM_MAX_PAYLOAD) {
+    return 1;
+  }
+
+  frame[0] = type;
+  frame[1] = sequence & 0xff;
+  frame[2] = sequence >> 8;
+  memcpy(&frame[TELEM_HEADER_LEN], payload, len);
+
+  len += TELEM_HEADER_LEN;
+  uint32_t crc = CRC_HAL_Calc(frame, len);
+  memcpy(&frame[len], &crc, TELEM_CRC_LEN); // little endian
+  len += TELEM_CRC_LEN;
+
+  // don't send partial frames - reserve for worst case encoding
+  if (COMM_TxReserve2(out) < len + len / 254 + 2) {
+    return 1;
+  }
+
+  len = TELEM_CobsEncode(frame, len, out);
+  *TELEM_SpanAt(out, len++) = 0; // frame delimiter
+
+  COMM_TxCommit(len);
+  sequence++; // host detects lost frames by gaps
+
+  return 0;
+}
+/**
+ * @brief Send samples waiting in ring.
+ * @details Batches are sent directly from the ring. Samples
+ * which don't fit into TX buffer wait for the next try.
+ */
+void TELEM_Flush(void) {
+
+  TELEM_Sample_TypeDef* batch;
+  uint16_t count;
+
+  while ((count = RING_Peek(&samples, (void**)&batch, TELEM_BATCH_LEN)) != 0) {
+
+    if (TELEM_SendFrame(TELEM_TYPE_SAMPLES, (uint8_t*)batch,
+        count * sizeof(TELEM_Sample_TypeDef))) {
+      return;
+    }
+
+    RING_Consume(&samples, count);
+  }
+}
+/**
+ * @brief Prints a sample.
+ * @details Without floating point formatting. The line is
+ * formatted later, when the log is flushed.
+ * @param sample Sample
+ * @param seq Sequence number in history (printed if history is nonzero)
+ * @param history Nonzero - sample from history
+ */
+static void TELEM_PrintSample(TELEM_Sample_TypeDef* sample, uint32_t seq, uint8_t history) {
+
+  int16_t temp = sample->temp;
+  uint16_t abs = (temp < 0) ? -temp : temp;
+
+  if (history) {
+    println("Sensor %d sample %u at %u ms temperature = %s%d.%04d", (int)sample->sensor,
+        (unsigned int)seq, (unsigned int)sample->time,
+        (temp < 0) ? "-" : "", abs >> 4, (abs & 0x0f) * 625);
+  } else {
+    println("Sensor %d temperature = %s%d.%04d", (int)sample->sensor,
+        (temp < 0) ? "-" : "", abs >> 4, (abs & 0x0f) * 625);
+  }
+}
+/**
+ * @brief Send a sensor sample.
+ * @details In binary mode the sample is written into the ring.
+ * In text mode it is logged right away. In both modes it is
+ * added to the history of the sensor.
+ * @param sensor Sensor number
+ * @param temp Temperature in 1/16 degrees Celsius
+ */
+void TELEM_AddSample(uint8_t sensor, int16_t temp) {
+
+  TELEM_Sample_TypeDef* sample;
+  TELEM_Sample_TypeDef newSample;
+
+  newSample.time   = TIMER_GetTime();
+  newSample.temp   = temp;
+  newSample.sensor = sensor;
+
+  if (sensor < TELEM_MAX_SENSORS) {
+    RING_PushOverwrite(&history[sensor], &newSample);
+  }
+
+  if (mode == TELEM_MODE_TEXT) {
+    TELEM_PrintSample(&newSample, 0, 0);
+    return;
+  }
+
+  // sample is written in place
+  if (RING_Reserve(&samples, (void**)&sample, 1) == 0) {
+    return; // ring full - sample dropped
+  }
+
+  *sample = newSample;
+  RING_Commit(&samples, 1);
+
+  if (RING_GetCount(&samples) >= TELEM_BATCH_LEN) {
+    TELEM_Flush();
+  }
+}
+/**
+ * @brief Send sample history of a sensor.
+ * @details Sends kept samples with sequence numbers starting from
+ * since (or the oldest kept sample), as long as there is room in
+ * TX buffer (log buffer in text mode).
+ * @param sensor Sensor number
+ * @param since Sequence number of first sample
+ * @return Sequence number of first sample not sent (to continue)
+ */
+uint32_t TELEM_SendHistory(uint8_t sensor, uint32_t since) {
+
+  uint8_t payload[TELEM_MAX_PAYLOAD];
+  TELEM_Sample_TypeDef* batch = (TELEM_Sample_TypeDef*)&payload[TELEM_HISTORY_HEADER];
+  uint16_t count;
+  uint16_t i;
+
+  if (sensor >= TELEM_MAX_SENSORS) {
+    return since;
+  }
+
+  while ((count = RING_ReadSince(&history[sensor], &since, batch, TELEM_HISTORY_BATCH)) != 0) {
+
+    if (mode == TELEM_MODE_TEXT) {
+
+      // whole lines only
+      for (i = 0; i < count && LOG_GetFree() >= LOG_MAX_RECORD; i++) {
+        TELEM_PrintSample(&batch[i], since + i, 1);
+      }
+      since += i;
+      if (i < count) {
+        break;
+      }
+
+    } else {
+
+      payload[0] = sensor;
+      memcpy(&payload[1], &since, sizeof(since)); // little endian
+      if (TELEM_SendFrame(TELEM_TYPE_HISTORY, payload,
+          TELEM_HISTORY_HEADER + count * sizeof(TELEM_Sample_TypeDef))) {
+        break;
+      }
+      since += count;
+    }
+  }
+
+  return since;
+}
+/**
+ * @brief Sends samples if a batch is full or oldest sample waits too long.
+ * @details This function should be called periodically in the main
+ * loop of the program.
+ */
+void TELEM_Update(void) {
+
+  TELEM_Sample_TypeDef* oldest;
+
+  if (RING_Peek(&samples, (void**)&oldest, 1) == 0) {
+    return;
+  }
+
+  if (RING_GetCount(&samples) >= TELEM_BATCH_LEN ||
+      TIMER_DelayTimer(TELEM_MAX_AGE, oldest->time)) {
+    TELEM_Flush();
+  }
+}
+
+/**
+ * @}
+ */
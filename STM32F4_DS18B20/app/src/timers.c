@@ -20,7 +20,10 @@
  */
 
 #include <timers.h>
+#include <hrtimer.h>
+#include <defer.h>
 #include <stdio.h>
+#include <log.h>
 #include <systick.h>
 #include <timer14.h>
 
@@ -29,8 +32,8 @@
 #endif
 
 #ifdef DEBUG
-  #define print(str, args...) printf("LED--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("LED--> "str"%s",##args,"\r\n")
+  #define print(str, args...) LOG("TIMER--> "str"\r", ##args)
+  #define println(str, args...) LOG("TIMER--> "str"\r\n", ##args)
 #else
   #define print(str, args...) (void)0
   #define println(str, args...) (void)0
@@ -45,6 +48,18 @@
 
 static uint8_t softTimerCount; ///< Count number of soft timers
 
+/**
+ * @brief Soft timer timing statistics.
+ */
+typedef struct {
+  uint32_t runs;      ///< Number of overflow callback runs
+  uint32_t misses;    ///< Number of runs which finished after the deadline
+  uint32_t execLast;  ///< Execution time of last run in us
+  uint32_t execMax;   ///< Worst execution time in us
+  uint32_t execTotal; ///< Sum of execution times in us (for average)
+  uint32_t lateMax;   ///< Worst start lateness in ms
+} TIMER_Stats_TypeDef;
+
 /**
  * @brief Soft timer structure.
  */
@@ -54,10 +69,29 @@ typedef struct {
   uint32_t max;                   ///< Overflow value
   uint8_t active;                 ///< Is timer active?
   void (*overflowCallback)(void); ///< Function called on overflow event
+  DEFER_Callback deferredCallback;///< Function posted to deferred queue on overflow event
+  void* ctx;                      ///< Context for deferred callback
+  uint32_t due;                   ///< System time the deferred callback was due
+  uint8_t pending;                ///< Deferred callback waits in queue
+  uint32_t deadline;              ///< Deadline for finishing callback in us (0 - timer period)
+  TIMER_Stats_TypeDef stats;      ///< Timing statistics
 } TIMER_Soft_TypeDef;
 
 static TIMER_Soft_TypeDef softTimers[MAX_SOFT_TIMERS]; ///< Array of soft timers
 
+#define MAX_DELAYED_CALLS 8 ///< Maximum number of pending delayed calls.
+
+/**
+ * @brief Delayed call structure.
+ */
+typedef struct {
+  uint32_t time;        ///< System time of call
+  DEFER_Callback fun;   ///< Function posted to deferred queue (NULL - slot free)
+  void* ctx;            ///< Context for function
+} TIMER_Call_TypeDef;
+
+static TIMER_Call_TypeDef delayedCalls[MAX_DELAYED_CALLS]; ///< Pending delayed calls
+
 /**
  * @brief Initiate the system time interrupt with a given frequency.
  * @param freq Required frequency of the timer in Hz
@@ -70,6 +104,20 @@ void TIMER_Init(uint32_t freq) {
   TIMER14_Init();
 
 }
+/**
+ * @brief Reconfigures all timers after a clock change.
+ * @details Call this function every time SYSCLK or the bus
+ * prescalers are changed (e.g. when slowing down the core
+ * in idle phases). Timer periods and prescalers are derived
+ * again from the current clock tree, so system time, us delays
+ * and high resolution timers keep their rate. Counts are not lost.
+ */
+void TIMER_ClockChanged(void) {
+
+  SYSTICK_UpdateClock();
+  TIMER14_UpdateClock();
+  HRTIMER_ClockChanged();
+}
 /**
  * @brief Returns the system time.
  * @return System time
@@ -78,6 +126,30 @@ uint32_t TIMER_GetTime(void) {
   return SYSTICK_GetTime();
 }
 
+/**
+ * @brief Sleeps until given system time.
+ * @details The core idles between interrupts (which are
+ * serviced normally) instead of spinning.
+ * @param time System time to wake up at (see TIMER_GetTime)
+ * @warning This is a blocking function for the main loop. For long
+ * waits use TIMER_CallAfter.
+ */
+void TIMER_SleepUntil(uint32_t time) {
+
+  // overflow safe comparison
+  while ((int32_t)(time - TIMER_GetTime()) > 0) {
+    SYSTICK_Sleep();
+  }
+}
+/**
+ * @brief Sleeps until next interrupt.
+ * @details Use in wait loops, which wait for a condition
+ * changed in an interrupt.
+ */
+void TIMER_Idle(void) {
+
+  SYSTICK_Sleep();
+}
 /**
  * @brief Delay function.
  * @param ms Milliseconds to delay.
@@ -85,19 +157,8 @@ uint32_t TIMER_GetTime(void) {
  */
 void TIMER_Delay(uint32_t ms) {
 
-  uint32_t startTime = TIMER_GetTime();
-  uint32_t currentTime;
-
-  while (1) { // Delay
-    currentTime = TIMER_GetTime();
-    if ((currentTime >= startTime) && (currentTime-startTime > ms)) {
-      break;
-    }
-    // account for system timer overflow
-    if ((currentTime < startTime) && (UINT32_MAX-startTime + currentTime > ms)) {
-      break;
-    }
-  }
+  // at least ms full ticks
+  TIMER_SleepUntil(TIMER_GetTime() + ms + 1);
 }
 
 /**
@@ -146,6 +207,34 @@ uint8_t TIMER_DelayTimer(uint32_t ms, uint32_t startTime) {
 
 }
 
+/**
+ * @brief Schedules a function to be run after a delay.
+ * @details This is the nonblocking replacement for TIMER_Delay:
+ * code after a long wait goes into a continuation function,
+ * which is posted to the deferred queue when the time passes.
+ * @param ms Delay time
+ * @param fun Function to call
+ * @param ctx Context pointer passed to fun
+ * @retval 0 Call scheduled
+ * @retval 1 Error: too many pending calls
+ */
+uint8_t TIMER_CallAfter(uint32_t ms, DEFER_Callback fun, void* ctx) {
+
+  uint8_t i;
+
+  for (i = 0; i < MAX_DELAYED_CALLS; i++) {
+    if (delayedCalls[i].fun == NULL) {
+      delayedCalls[i].time = TIMER_GetTime() + ms;
+      delayedCalls[i].ctx  = ctx;
+      delayedCalls[i].fun  = fun;
+      return 0;
+    }
+  }
+
+  println("Reached maximum number of delayed calls!");
+  return 1;
+}
+
 /**
  * @brief Adds a soft timer
  * @param maxVal Overflow value of timer
@@ -155,28 +244,66 @@ uint8_t TIMER_DelayTimer(uint32_t ms, uint32_t startTime) {
  */
 int8_t TIMER_AddSoftTimer(uint32_t maxVal, void (*fun)(void)) {
 
-  if (softTimerCount > MAX_SOFT_TIMERS) {
+  if (softTimerCount >= MAX_SOFT_TIMERS) {
     println("TIMERS: Reached maximum number of timers!");
     return -1;
   }
 
   softTimers[softTimerCount].id = softTimerCount;
   softTimers[softTimerCount].overflowCallback = fun;
+  softTimers[softTimerCount].deferredCallback = NULL;
+  softTimers[softTimerCount].ctx = NULL;
   softTimers[softTimerCount].max = maxVal;
   softTimers[softTimerCount].value = 0;
   softTimers[softTimerCount].active = 0; // inactive on startup
+  softTimers[softTimerCount].deadline = 0; // deadline equal to period
+  softTimers[softTimerCount].pending = 0;
 
   softTimerCount++;
 
+  TIMER_ResetStats(softTimerCount - 1);
+
   return (softTimerCount - 1);
 }
 
+/**
+ * @brief Adds a soft timer with a deferred callback
+ * @details On overflow the callback is posted to the deferred
+ * queue (see DEFER_Post) instead of being run inline,
+ * so it runs when the main loop calls DEFER_Run. Lateness is
+ * measured up to the start of the deferred run. An overflow while
+ * the previous run still waits in the queue is counted as a miss.
+ * @param maxVal Overflow value of timer
+ * @param fun Function posted on overflow
+ * @param ctx Context pointer passed to fun
+ * @return Returns the ID of the new counter or error code (-1)
+ * @retval -1 Error: too many timers
+ */
+int8_t TIMER_AddSoftTimerDeferred(uint32_t maxVal, DEFER_Callback fun, void* ctx) {
+
+  int8_t id = TIMER_AddSoftTimer(maxVal, NULL);
+
+  if (id < 0) {
+    return id;
+  }
+
+  softTimers[id].deferredCallback = fun;
+  softTimers[id].ctx = ctx;
+
+  return id;
+}
+
 /**
  * @brief Starts the timer (zeroes out current count value).
  * @param id Timer ID
  */
 void TIMER_StartSoftTimer(uint8_t id) {
 
+  if (id >= softTimerCount) {
+    println("Incorrect timer ID %d!", (int)id);
+    return;
+  }
+
   softTimers[id].value = 0;
   softTimers[id].active = 1; // start timer
 }
@@ -186,6 +313,11 @@ void TIMER_StartSoftTimer(uint8_t id) {
  */
 void TIMER_PauseSoftTimer(uint8_t id) {
 
+  if (id >= softTimerCount) {
+    println("Incorrect timer ID %d!", (int)id);
+    return;
+  }
+
   softTimers[id].active = 0; // pause timer
 }
 /**
@@ -194,8 +326,153 @@ void TIMER_PauseSoftTimer(uint8_t id) {
  */
 void TIMER_ResumeSoftTimer(uint8_t id) {
 
+  if (id >= softTimerCount) {
+    println("Incorrect timer ID %d!", (int)id);
+    return;
+  }
+
   softTimers[id].active = 1; // start timer
 }
+/**
+ * @brief Get effective deadline of a soft timer.
+ * @param id Timer ID
+ * @return Deadline in microseconds
+ */
+static uint32_t TIMER_GetDeadline(uint8_t id) {
+
+  if (softTimers[id].deadline) {
+    return softTimers[id].deadline;
+  }
+
+  return softTimers[id].max * 1000; // timer period in us
+}
+/**
+ * @brief Compares timing statistics of two soft timers.
+ * @param a First timer ID
+ * @param b Second timer ID
+ * @retval 1 Timer a behaves worse than timer b
+ * @retval 0 Timer a does not behave worse than timer b
+ */
+static uint8_t TIMER_IsWorse(uint8_t a, uint8_t b) {
+
+  if (softTimers[a].stats.misses != softTimers[b].stats.misses) {
+    return softTimers[a].stats.misses > softTimers[b].stats.misses;
+  }
+
+  return softTimers[a].stats.execMax > softTimers[b].stats.execMax;
+}
+/**
+ * @brief Sets deadline of a soft timer.
+ * @details A run of the overflow callback counts as a deadline miss if
+ * its start lateness plus execution time exceeds the deadline.
+ * @param id Timer ID
+ * @param us Deadline in microseconds (0 - use timer period)
+ */
+void TIMER_SetSoftTimerDeadline(uint8_t id, uint32_t us) {
+
+  if (id >= softTimerCount) {
+    println("Incorrect timer ID %d!", (int)id);
+    return;
+  }
+
+  softTimers[id].deadline = us;
+}
+/**
+ * @brief Zeroes out timing statistics of a soft timer.
+ * @param id Timer ID
+ */
+void TIMER_ResetStats(uint8_t id) {
+
+  if (id >= softTimerCount) {
+    println("Incorrect timer ID %d!", (int)id);
+    return;
+  }
+
+  softTimers[id].stats.runs      = 0;
+  softTimers[id].stats.misses    = 0;
+  softTimers[id].stats.execLast  = 0;
+  softTimers[id].stats.execMax   = 0;
+  softTimers[id].stats.execTotal = 0;
+  softTimers[id].stats.lateMax   = 0;
+}
+/**
+ * @brief Prints timing statistics of all soft timers.
+ * @details Timers are sorted by number of deadline misses and
+ * then by worst execution time, so worst offenders come first.
+ */
+void TIMER_PrintStats(void) {
+
+  uint8_t order[MAX_SOFT_TIMERS];
+  uint8_t i, j;
+
+  // insertion sort of timer IDs - worst first
+  for (i = 0; i < softTimerCount; i++) {
+    j = i;
+    while (j > 0 && TIMER_IsWorse(i, order[j-1])) {
+      order[j] = order[j-1];
+      j--;
+    }
+    order[j] = i;
+  }
+
+  // table is printed right away (not deferred by LOG)
+  printf("TIMER--> ID     RUNS   MISSES  DEADLINE  EXEC_LAST  EXEC_AVG  EXEC_MAX  LATE_MAX\r\n");
+
+  for (i = 0; i < softTimerCount; i++) {
+
+    TIMER_Soft_TypeDef* t = &softTimers[order[i]];
+
+    printf("TIMER--> %2d %8lu %8lu %7luus %8luus %7luus %7luus %7lums\r\n",
+        (int)t->id,
+        (unsigned long)t->stats.runs,
+        (unsigned long)t->stats.misses,
+        (unsigned long)TIMER_GetDeadline(t->id),
+        (unsigned long)t->stats.execLast,
+        (unsigned long)(t->stats.runs ? t->stats.execTotal / t->stats.runs : 0),
+        (unsigned long)t->stats.execMax,
+        (unsigned long)t->stats.lateMax);
+  }
+}
+/**
+ * @brief Updates timing statistics after running overflow callback.
+ * @param id Timer ID
+ * @param late Start lateness in ms
+ * @param exec Execution time in us
+ */
+static void TIMER_UpdateStats(uint8_t id, uint32_t late, uint32_t exec) {
+
+  TIMER_Stats_TypeDef* stats = &softTimers[id].stats;
+
+  stats->runs++;
+  stats->execLast   = exec;
+  stats->execTotal += exec;
+
+  if (exec > stats->execMax) {
+    stats->execMax = exec;
+  }
+  if (late > stats->lateMax) {
+    stats->lateMax = late;
+  }
+  if (late * 1000 + exec > TIMER_GetDeadline(id)) {
+    stats->misses++;
+  }
+}
+/**
+ * @brief Runs deferred callback of a soft timer and measures it.
+ * @details Posted to the deferred queue instead of the callback,
+ * so lateness includes time spent waiting in the queue.
+ * @param ctx Soft timer
+ */
+static void TIMER_RunDeferred(void* ctx) {
+
+  TIMER_Soft_TypeDef* timer = ctx;
+
+  timer->pending = 0; // next overflow can be queued
+  uint32_t late = TIMER_GetTime() - timer->due;
+  uint32_t start = TIMER14_GetTime();
+  timer->deferredCallback(timer->ctx);
+  TIMER_UpdateStats(timer->id, late, TIMER14_GetTime() - start);
+}
 /**
  * @brief Updates all the timers and calls the overflow functions as
  * necessary
@@ -231,10 +508,42 @@ void TIMER_SoftTimersUpdate(void) {
       softTimers[i].value += delta; // update active timer values
 
       if (softTimers[i].value >= softTimers[i].max) { // if overflow
+
+        // how late the timer is in ms
+        uint32_t late = softTimers[i].value - softTimers[i].max;
+
         softTimers[i].value = 0; // zero out timer
         if (softTimers[i].overflowCallback != NULL) {
+          uint32_t start = TIMER14_GetTime();
           softTimers[i].overflowCallback(); // call the overflow function
+          TIMER_UpdateStats(i, late, TIMER14_GetTime() - start);
         }
+        if (softTimers[i].deferredCallback != NULL) {
+          if (softTimers[i].pending) {
+            // previous run still waits - this one is lost
+            softTimers[i].stats.misses++;
+          } else {
+            // queue the callback to be run by the main loop
+            softTimers[i].due = sysTicks - late;
+            softTimers[i].pending = 1;
+            if (DEFER_Post(TIMER_RunDeferred, &softTimers[i])) {
+              softTimers[i].pending = 0;
+              softTimers[i].stats.misses++; // run lost - queue full
+            }
+          }
+        }
+      }
+    }
+  }
+
+  for (i = 0; i < MAX_DELAYED_CALLS; i++) {
+
+    if (delayedCalls[i].fun != NULL &&
+        (int32_t)(sysTicks - delayedCalls[i].time) >= 0) {
+
+      // keep the call for next run if the queue is full
+      if (DEFER_Post(delayedCalls[i].fun, delayedCalls[i].ctx) == 0) {
+        delayedCalls[i].fun = NULL; // free slot
       }
     }
   }
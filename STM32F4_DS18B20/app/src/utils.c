@@ -19,17 +19,21 @@
 #include <utils.h>
 #include <stdio.h>
 #include <timers.h>
+#include <comm.h>
 
 /**
  * @addtogroup UTILS
  * @{
  */
 
+#define HEXDUMP_LINE_LEN  (16 * 3 + 2) ///< Characters in one full line of hexdump
+
 /**
  * @brief Send data in hex format to terminal.
  * @param buf Data buffer.
  * @param length Number of bytes to send.
- * @warning Uses blocking delays so as not to overflow buffer.
+ * @warning Sleeps until there is room in the transmit
+ * buffer so as not to overflow it.
  */
 void hexdump(uint8_t* buf, uint32_t length) {
 
@@ -37,6 +41,13 @@ void hexdump(uint8_t* buf, uint32_t length) {
 
   while (length--) {
 
+    // wait for room for a full line - transmitter wakes us up
+    if ((i % 16) == 0) {
+      while (COMM_GetTxFree() < HEXDUMP_LINE_LEN) {
+        TIMER_Idle();
+      }
+    }
+
     printf("%02x ", buf[i]);
 
     i++;
@@ -44,10 +55,6 @@ void hexdump(uint8_t* buf, uint32_t length) {
     if ((i % 16) == 0) {
       printf("\r\n");
     }
-    // delay every 50 chars
-    if ((i % 50) == 0) {
-      TIMER_Delay(100); // Delay so as not to overflow buffer
-    }
   }
 }
 
@@ -0,0 +1,43 @@
+/**
+ * @file:   clocks.h
+ * @brief:  Clock tree helper functions
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef CLOCKS_H_
+#define CLOCKS_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  CLOCKS CLOCKS
+ * @brief     Clock tree helper functions
+ */
+
+/**
+ * @addtogroup CLOCKS
+ * @{
+ */
+
+uint32_t CLOCKS_GetHCLKFreq       (void);
+uint32_t CLOCKS_GetPCLK1Freq      (void);
+uint32_t CLOCKS_GetPCLK2Freq      (void);
+uint32_t CLOCKS_GetAPB1TimerFreq  (void);
+uint32_t CLOCKS_GetAPB2TimerFreq  (void);
+
+/**
+ * @}
+ */
+
+#endif /* CLOCKS_H_ */
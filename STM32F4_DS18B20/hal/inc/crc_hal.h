@@ -0,0 +1,40 @@
+/**
+ * @file:   crc_hal.h
+ * @brief:  Hardware CRC unit
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef CRC_HAL_H_
+#define CRC_HAL_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  CRC_HAL CRC_HAL
+ * @brief     Hardware CRC unit
+ */
+
+/**
+ * @addtogroup CRC_HAL
+ * @{
+ */
+
+void      CRC_HAL_Init  (void);
+uint32_t  CRC_HAL_Calc  (const uint8_t* buf, uint16_t len);
+
+/**
+ * @}
+ */
+
+#endif /* CRC_HAL_H_ */
@@ -0,0 +1,40 @@
+/**
+ * @file:   critical.h
+ * @brief:  Critical sections
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef CRITICAL_H_
+#define CRITICAL_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  CRITICAL CRITICAL
+ * @brief     Critical sections
+ */
+
+/**
+ * @addtogroup CRITICAL
+ * @{
+ */
+
+uint32_t  CRITICAL_Enter  (void);
+void      CRITICAL_Exit   (uint32_t state);
+
+/**
+ * @}
+ */
+
+#endif /* CRITICAL_H_ */
@@ -20,8 +20,16 @@
 
 #include <inttypes.h>
 
-int8_t KEYS_HAL_ReadRow(void);
-void KEYS_HAL_SelectColumn(uint8_t col);
-void KEYS_HAL_Init(void);
+#define KEYS_HAL_COLUMNS  4 ///< Number of keyboard columns
+#define KEYS_HAL_ROWS     4 ///< Number of keyboard rows
+
+uint8_t KEYS_HAL_ReadRows(void);
+uint16_t KEYS_HAL_ReadMatrix(void);
+void KEYS_HAL_StartScan(void);
+void KEYS_HAL_StopScan(void);
+void KEYS_HAL_SelectAllColumns(void);
+void KEYS_HAL_Init(void (*edgeCb)(void));
+void KEYS_HAL_EnableEdgeIrq(void);
+void KEYS_HAL_DisableEdgeIrq(void);
 
 #endif /* KEYS_HAL_H_ */
@@ -34,8 +34,7 @@
 #define MAX_LEDS    4 ///< Maximum number of LEDs available in design
 
 void LED_HAL_Init         (uint8_t led);
-void LED_HAL_Toggle       (uint8_t led);
-void LED_HAL_ChangeState  (uint8_t led, uint8_t state);
+void LED_HAL_Write        (uint32_t on, uint32_t off);
 
 /**
  * @}
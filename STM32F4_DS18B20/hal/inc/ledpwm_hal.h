@@ -0,0 +1,46 @@
+/**
+ * @file:   ledpwm_hal.h
+ * @brief:  HAL - LED brightness control with timer PWM
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef LEDPWM_HAL_H_
+#define LEDPWM_HAL_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  LEDPWM_HAL LEDPWM_HAL
+ * @brief     HAL - LED brightness control with timer PWM
+ */
+
+/**
+ * @addtogroup LEDPWM_HAL
+ * @{
+ */
+
+#define LEDPWM_HAL_CHANNELS   4   ///< Number of PWM channels (same numbers as LEDs)
+#define LEDPWM_HAL_FRAMES     32  ///< Number of frames in half of compare table
+#define LEDPWM_HAL_FRAME_TIME 1   ///< Time of one frame (PWM period) in ms
+#define LEDPWM_HAL_MAX_LEVEL  255 ///< Compare value for full brightness
+
+void LEDPWM_HAL_Init          (void (*fillCb)(uint16_t* frames, uint16_t count));
+void LEDPWM_HAL_EnableOutput  (uint8_t channel);
+void LEDPWM_HAL_UpdateClock   (void);
+
+/**
+ * @}
+ */
+
+#endif /* LEDPWM_HAL_H_ */
@@ -18,7 +18,10 @@
 #ifndef TIMER14_H_
 #define TIMER14_H_
 
+#include <inttypes.h>
+
 void TIMER14_Init(void);
 uint32_t TIMER14_GetTime(void);
+void TIMER14_UpdateClock(void);
 
 #endif /* TIMER14_H_ */
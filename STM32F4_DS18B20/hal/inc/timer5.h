@@ -0,0 +1,56 @@
+/**
+ * @file:   timer5.h
+ * @brief:  TIMER5 compare channels as microsecond alarms
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef TIMER5_H_
+#define TIMER5_H_
+
+#include <inttypes.h>
+#include <critical.h>
+
+/**
+ * @defgroup  TIMER5 TIMER5
+ * @brief     TIMER5 low level functions
+ */
+
+/**
+ * @addtogroup TIMER5
+ * @{
+ */
+
+#define TIMER5_CHANNELS 4 ///< Number of compare channels
+
+void      TIMER5_Init           (void(*compareCb)(uint8_t));
+void      TIMER5_UpdateClock    (void);
+uint32_t  TIMER5_GetTime        (void);
+void      TIMER5_SetCompare     (uint8_t ch, uint32_t time);
+void      TIMER5_DisableCompare (uint8_t ch);
+
+// HAL functions for use in higher level
+#define HRTIMER_HAL_CHANNELS        TIMER5_CHANNELS
+#define HRTIMER_HAL_Init            TIMER5_Init
+#define HRTIMER_HAL_UpdateClock     TIMER5_UpdateClock
+#define HRTIMER_HAL_GetTime         TIMER5_GetTime
+#define HRTIMER_HAL_SetCompare      TIMER5_SetCompare
+#define HRTIMER_HAL_DisableCompare  TIMER5_DisableCompare
+#define HRTIMER_HAL_Lock            CRITICAL_Enter
+#define HRTIMER_HAL_Unlock          CRITICAL_Exit
+
+/**
+ * @}
+ */
+
+#endif /* TIMER5_H_ */
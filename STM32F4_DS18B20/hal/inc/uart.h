@@ -0,0 +1,66 @@
+/**
+ * @file:   uart.h
+ * @brief:  Controlling UART
+ * @date:   12 kwi 2014
+ * @author: Michal Ksiezopolski
+ * 
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the 
+ * accompanying materials are made available 
+ * under the terms of the GNU Public License 
+ * v3.0 which accompanies this distribution, 
+ * and is available at 
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef UART_H_
+#define UART_H_
+
+#include <inttypes.h>
+#include <stm32f4xx.h>
+/**
+ * @defgroup  UART UART
+ * @brief     USART low level functions
+ */
+
+/**
+ * @addtogroup UART
+ * @{
+ */
+
+/**
+ * @brief Available ports.
+ */
+typedef enum {
+  UART_PORT1, //!< UART_PORT1 USART1: TX PA9,  RX PA10
+  UART_PORT2, //!< UART_PORT2 USART2: TX PA2,  RX PA3
+  UART_PORT3, //!< UART_PORT3 USART3: TX PB10, RX PB11
+  UART_PORT6, //!< UART_PORT6 USART6: TX PC6,  RX PC7
+  UART_PORTS, //!< UART_PORTS Number of ports
+} UART_Port_TypeDef;
+
+void    UART_Init(uint8_t port, uint32_t baud, void* ctx,
+    void(*rxCb)(void*, uint8_t*, uint16_t), uint16_t(*txCb)(void*, uint16_t, uint8_t**));
+void    UART_TxEnable(uint8_t port);
+void    UART_UpdateClock(uint8_t port);
+uint32_t UART_SetBaud(uint8_t port, uint32_t baud);
+uint32_t UART_GetBaud(uint8_t port);
+uint32_t UART_CalcBaud(uint8_t port, uint32_t baud);
+
+// HAL functions for use in higher level
+#define COMM_HAL_PORTS      UART_PORTS
+#define COMM_HAL_CONSOLE    UART_PORT2
+#define COMM_HAL_Init       UART_Init
+#define COMM_HAL_TxEnable   UART_TxEnable
+#define COMM_HAL_UpdateClock UART_UpdateClock
+#define COMM_HAL_SetBaud    UART_SetBaud
+#define COMM_HAL_GetBaud    UART_GetBaud
+#define COMM_HAL_CalcBaud   UART_CalcBaud
+
+/**
+ * @}
+ */
+
+#endif /* UART_H_ */
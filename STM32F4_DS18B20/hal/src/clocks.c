@@ -0,0 +1,105 @@
+/**
+ * @file:   clocks.c
+ * @brief:  Clock tree helper functions
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @details Peripherals which depend on a clock frequency should
+ * take it from here instead of assuming the values set
+ * in system_stm32f4xx.c.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <clocks.h>
+#include <stm32f4xx.h>
+
+/**
+ * @addtogroup CLOCKS
+ * @{
+ */
+
+/**
+ * @brief Get current AHB clock frequency.
+ * @return HCLK frequency in Hz
+ */
+uint32_t CLOCKS_GetHCLKFreq(void) {
+
+  RCC_ClocksTypeDef RCC_Clocks;
+
+  RCC_GetClocksFreq(&RCC_Clocks); // Complete the clocks structure with current clock settings.
+
+  return RCC_Clocks.HCLK_Frequency;
+}
+/**
+ * @brief Get current APB1 clock frequency.
+ * @return PCLK1 frequency in Hz
+ */
+uint32_t CLOCKS_GetPCLK1Freq(void) {
+
+  RCC_ClocksTypeDef RCC_Clocks;
+
+  RCC_GetClocksFreq(&RCC_Clocks); // Complete the clocks structure with current clock settings.
+
+  return RCC_Clocks.PCLK1_Frequency;
+}
+/**
+ * @brief Get current APB2 clock frequency.
+ * @return PCLK2 frequency in Hz
+ */
+uint32_t CLOCKS_GetPCLK2Freq(void) {
+
+  RCC_ClocksTypeDef RCC_Clocks;
+
+  RCC_GetClocksFreq(&RCC_Clocks); // Complete the clocks structure with current clock settings.
+
+  return RCC_Clocks.PCLK2_Frequency;
+}
+/**
+ * @brief Get current clock frequency of timers on APB1 bus.
+ * @details If APB1 prescaler is not 1, timers on APB1 are
+ * clocked at twice the APB1 frequency.
+ * @return Timer clock frequency in Hz
+ */
+uint32_t CLOCKS_GetAPB1TimerFreq(void) {
+
+  RCC_ClocksTypeDef RCC_Clocks;
+
+  RCC_GetClocksFreq(&RCC_Clocks); // Complete the clocks structure with current clock settings.
+
+  if ((RCC->CFGR & RCC_CFGR_PPRE1) == RCC_CFGR_PPRE1_DIV1) {
+    return RCC_Clocks.PCLK1_Frequency;
+  }
+
+  return 2 * RCC_Clocks.PCLK1_Frequency;
+}
+
+/**
+ * @brief Get current clock frequency of timers on APB2 bus.
+ * @details If APB2 prescaler is not 1, timers on APB2 are
+ * clocked at twice the APB2 frequency.
+ * @return Timer clock frequency in Hz
+ */
+uint32_t CLOCKS_GetAPB2TimerFreq(void) {
+
+  RCC_ClocksTypeDef RCC_Clocks;
+
+  RCC_GetClocksFreq(&RCC_Clocks); // Complete the clocks structure with current clock settings.
+
+  if ((RCC->CFGR & RCC_CFGR_PPRE2) == RCC_CFGR_PPRE2_DIV1) {
+    return RCC_Clocks.PCLK2_Frequency;
+  }
+
+  return 2 * RCC_Clocks.PCLK2_Frequency;
+}
+/**
+ * @}
+ */
@@ -0,0 +1,69 @@
+/**
+ * @file:   crc_hal.c
+ * @brief:  Hardware CRC unit
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @details The STM32F4 CRC unit calculates CRC-32 (polynomial
+ * 0x04C11DB7, initial value 0xFFFFFFFF, no reflection, no final
+ * XOR) over 32 bit words. Bytes are taken as little endian words.
+ * A trailing part shorter than a word is padded with zeros.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <crc_hal.h>
+#include <stm32f4xx.h>
+#include <string.h>
+
+/**
+ * @addtogroup CRC_HAL
+ * @{
+ */
+
+/**
+ * @brief Initialize hardware CRC unit.
+ */
+void CRC_HAL_Init(void) {
+
+  RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_CRC, ENABLE);
+}
+/**
+ * @brief Calculate CRC of a block of data.
+ * @param buf Data
+ * @param len Number of bytes
+ * @return CRC value
+ */
+uint32_t CRC_HAL_Calc(const uint8_t* buf, uint16_t len) {
+
+  uint32_t word;
+
+  CRC_ResetDR();
+
+  while (len >= 4) {
+    memcpy(&word, buf, 4); // buffer doesn't have to be aligned
+    CRC->DR = word;
+    buf += 4;
+    len -= 4;
+  }
+
+  if (len) { // pad last word with zeros
+    word = 0;
+    memcpy(&word, buf, len);
+    CRC->DR = word;
+  }
+
+  return CRC->DR;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,51 @@
+/**
+ * @file:   critical.c
+ * @brief:  Critical sections
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @details Critical sections mask all interrupts and can be
+ * nested - each exit restores the state from its enter.
+ * Keep them as short as possible.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <critical.h>
+#include <stm32f4xx.h>
+
+/**
+ * @addtogroup CRITICAL
+ * @{
+ */
+
+/**
+ * @brief Enter critical section (masks all interrupts).
+ * @return Previous interrupt mask state (pass to CRITICAL_Exit)
+ */
+uint32_t CRITICAL_Enter(void) {
+
+  uint32_t state = __get_PRIMASK();
+  __disable_irq();
+  return state;
+}
+/**
+ * @brief Leave critical section.
+ * @param state Interrupt mask state returned by CRITICAL_Enter
+ */
+void CRITICAL_Exit(uint32_t state) {
+
+  __set_PRIMASK(state);
+}
+
+/**
+ * @}
+ */
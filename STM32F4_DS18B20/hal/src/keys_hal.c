@@ -16,6 +16,7 @@
  */
 
 #include <keys_hal.h>
+#include <clocks.h>
 #include <stm32f4xx.h>
 
 
@@ -38,10 +39,58 @@
 #define KEYS_COL_PORT   GPIOE
 #define KEYS_COL_CLOCK  RCC_AHB1Periph_GPIOE
 
+#define KEYS_COL_PINS   (KEYS_COL0_PIN | KEYS_COL1_PIN | KEYS_COL2_PIN | KEYS_COL3_PIN)
+#define KEYS_ROW_PINS   (KEYS_ROW0_PIN | KEYS_ROW1_PIN | KEYS_ROW2_PIN | KEYS_ROW3_PIN)
+#define KEYS_ROW_SHIFT  11 ///< Position of row 0 pin - rows are consecutive pins
+
+#define KEYS_EXTI_PORT  EXTI_PortSourceGPIOE
+#define KEYS_EXTI_LINES (EXTI_Line11 | EXTI_Line12 | EXTI_Line13 | EXTI_Line14) ///< Same numbers as row pins
+#define KEYS_EXTI_IRQ   EXTI15_10_IRQn
+
+/*
+ * Background scan - TIM1 update writes the next column pattern
+ * to the column port BSRR, TIM1 compare 1 (later in the same
+ * period, after the column settled) copies the row port IDR
+ * to the snapshot. Both requests are served by DMA2, the only
+ * DMA controller with access to AHB1 GPIO ports.
+ */
+#define KEYS_SCAN_TIMER       TIM1
+#define KEYS_SCAN_TIMER_CLOCK RCC_APB2Periph_TIM1
+#define KEYS_SCAN_DMA_CLOCK   RCC_AHB1Periph_DMA2
+#define KEYS_COL_STREAM       DMA2_Stream5  ///< TIM1_UP
+#define KEYS_COL_CHANNEL      DMA_Channel_6
+#define KEYS_ROW_STREAM       DMA2_Stream3  ///< TIM1_CH1
+#define KEYS_ROW_CHANNEL      DMA_Channel_6
+#define KEYS_COLUMN_TIME      1000 ///< Time each column is selected in us
+#define KEYS_SETTLE_TIME      500  ///< Time from column select to row read in us
+
+static void (*edgeCallback)(void); ///< Called on falling edge of a row
+
+/**
+ * @brief BSRR values selecting each column.
+ * @details Other columns are set high, selected column is reset
+ * (set bits win over reset bits, so the column is not set).
+ */
+static const uint32_t columnPattern[KEYS_HAL_COLUMNS] = {
+    (KEYS_COL_PINS & ~KEYS_COL0_PIN) | (KEYS_COL0_PIN << 16),
+    (KEYS_COL_PINS & ~KEYS_COL1_PIN) | (KEYS_COL1_PIN << 16),
+    (KEYS_COL_PINS & ~KEYS_COL2_PIN) | (KEYS_COL2_PIN << 16),
+    (KEYS_COL_PINS & ~KEYS_COL3_PIN) | (KEYS_COL3_PIN << 16),
+};
+
+static volatile uint32_t rowSnapshot[KEYS_HAL_COLUMNS]; ///< Row port IDR read with each column selected
+
 /**
  * @brief Initialize 4x4 matrix keyboard
+ * @details Falling edges on rows (key pressed while its column
+ * is low) generate interrupts, which are enabled with
+ * KEYS_HAL_EnableEdgeIrq.
+ * @param edgeCb Function called (in interrupt context) on falling
+ * edge of a row - the interrupt is disabled until enabled again
  */
-void KEYS_HAL_Init(void) {
+void KEYS_HAL_Init(void (*edgeCb)(void)) {
+
+  edgeCallback = edgeCb;
 
   // Enable clocks
   RCC_AHB1PeriphClockCmd(KEYS_ROW_CLOCK, ENABLE);
@@ -50,8 +99,7 @@ void KEYS_HAL_Init(void) {
   GPIO_InitTypeDef GPIO_InitStructure;
 
   // Configure row pins in input pulled-up mode
-  GPIO_InitStructure.GPIO_Pin   = KEYS_ROW0_PIN | KEYS_ROW1_PIN |
-      KEYS_ROW2_PIN | KEYS_ROW3_PIN;
+  GPIO_InitStructure.GPIO_Pin   = KEYS_ROW_PINS;
   GPIO_InitStructure.GPIO_OType = GPIO_OType_PP; // irrelevant
   GPIO_InitStructure.GPIO_Speed = GPIO_Speed_2MHz; // irrelevant
   GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_IN;
@@ -69,53 +117,201 @@ void KEYS_HAL_Init(void) {
 
   GPIO_Init(KEYS_COL_PORT, &GPIO_InitStructure);
 
+  // Connect rows to EXTI lines
+  RCC_APB2PeriphClockCmd(RCC_APB2Periph_SYSCFG, ENABLE);
+  SYSCFG_EXTILineConfig(KEYS_EXTI_PORT, EXTI_PinSource11);
+  SYSCFG_EXTILineConfig(KEYS_EXTI_PORT, EXTI_PinSource12);
+  SYSCFG_EXTILineConfig(KEYS_EXTI_PORT, EXTI_PinSource13);
+  SYSCFG_EXTILineConfig(KEYS_EXTI_PORT, EXTI_PinSource14);
+
+  // Falling edge interrupts, masked for now
+  EXTI_InitTypeDef EXTI_InitStructure;
+  EXTI_InitStructure.EXTI_Line    = KEYS_EXTI_LINES;
+  EXTI_InitStructure.EXTI_Mode    = EXTI_Mode_Interrupt;
+  EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Falling;
+  EXTI_InitStructure.EXTI_LineCmd = ENABLE;
+  EXTI_Init(&EXTI_InitStructure);
+
+  KEYS_HAL_DisableEdgeIrq();
+
+  NVIC_EnableIRQ(KEYS_EXTI_IRQ);
+
+  // Scan timer and DMA
+  RCC_APB2PeriphClockCmd(KEYS_SCAN_TIMER_CLOCK, ENABLE);
+  RCC_AHB1PeriphClockCmd(KEYS_SCAN_DMA_CLOCK, ENABLE);
+
+  // compare channel only requests DMA - no output pin
+  TIM_OCInitTypeDef TIM_OCInitStructure;
+  TIM_OCStructInit(&TIM_OCInitStructure);
+  TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_Timing;
+  TIM_OCInitStructure.TIM_Pulse = KEYS_SETTLE_TIME;
+  TIM_OC1Init(KEYS_SCAN_TIMER, &TIM_OCInitStructure);
+
 }
 /**
- * @brief Select a column
- * @param col Column number
+ * @brief Calculate scan timer prescaler giving 1 MHz count
+ * @details Below 1 MHz timer clock the timer counts at the timer clock.
+ * @return Prescaler value for current timer clock
  */
-void KEYS_HAL_SelectColumn(uint8_t col) {
-
-  // set all columns high
-  GPIO_SetBits(KEYS_COL_PORT, KEYS_COL0_PIN | KEYS_COL1_PIN |
-      KEYS_COL2_PIN | KEYS_COL3_PIN);
-
-  // set selected column as low
-  switch (col) {
-  case 0:
-    GPIO_ResetBits(KEYS_COL_PORT, KEYS_COL0_PIN);
-    break;
-  case 1:
-    GPIO_ResetBits(KEYS_COL_PORT, KEYS_COL1_PIN);
-    break;
-  case 2:
-    GPIO_ResetBits(KEYS_COL_PORT, KEYS_COL2_PIN);
-    break;
-  case 3:
-    GPIO_ResetBits(KEYS_COL_PORT, KEYS_COL3_PIN);
-    break;
-  default:
-    break;
+static uint16_t KEYS_HAL_GetPrescaler(void) {
+
+  uint32_t div = CLOCKS_GetAPB2TimerFreq() / 1000000;
+
+  return div ? div - 1 : 0;
+}
+/**
+ * @brief Configure a scan DMA stream.
+ * @param stream DMA stream
+ * @param channel Stream channel
+ * @param periph Peripheral register address
+ * @param mem Table of one word per column
+ * @param dir Transfer direction
+ */
+static void KEYS_HAL_InitStream(DMA_Stream_TypeDef* stream, uint32_t channel,
+    uint32_t periph, uint32_t mem, uint32_t dir) {
+
+  DMA_InitTypeDef DMA_InitStructure;
+
+  DMA_DeInit(stream);
+  DMA_StructInit(&DMA_InitStructure);
+  DMA_InitStructure.DMA_Channel             = channel;
+  DMA_InitStructure.DMA_PeripheralBaseAddr  = periph;
+  DMA_InitStructure.DMA_Memory0BaseAddr     = mem;
+  DMA_InitStructure.DMA_DIR                 = dir;
+  DMA_InitStructure.DMA_BufferSize          = KEYS_HAL_COLUMNS;
+  DMA_InitStructure.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
+  DMA_InitStructure.DMA_MemoryInc           = DMA_MemoryInc_Enable;
+  DMA_InitStructure.DMA_PeripheralDataSize  = DMA_PeripheralDataSize_Word;
+  DMA_InitStructure.DMA_MemoryDataSize      = DMA_MemoryDataSize_Word;
+  DMA_InitStructure.DMA_Mode                = DMA_Mode_Circular;
+  DMA_InitStructure.DMA_Priority            = DMA_Priority_Medium;
+  DMA_Init(stream, &DMA_InitStructure);
+
+  DMA_Cmd(stream, ENABLE);
+}
+/**
+ * @brief Start background scanning of the keyboard.
+ * @details Every KEYS_COLUMN_TIME the next column is selected and
+ * rows are captured, without any CPU work. Timer prescaler is
+ * calculated from the current clock on every start, so clock
+ * changes are picked up the next time scanning starts.
+ */
+void KEYS_HAL_StartScan(void) {
+
+  uint8_t i;
+
+  // no data yet - all keys released
+  for (i = 0; i < KEYS_HAL_COLUMNS; i++) {
+    rowSnapshot[i] = KEYS_ROW_PINS;
   }
 
+  TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+  TIM_TimeBaseStructure.TIM_Prescaler = KEYS_HAL_GetPrescaler(); // 1 MHz count
+  TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+  TIM_TimeBaseStructure.TIM_Period = KEYS_COLUMN_TIME - 1;
+  TIM_TimeBaseStructure.TIM_ClockDivision = 0;
+  TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+  TIM_TimeBaseInit(KEYS_SCAN_TIMER, &TIM_TimeBaseStructure);
+
+  KEYS_HAL_InitStream(KEYS_COL_STREAM, KEYS_COL_CHANNEL,
+      (uint32_t)&KEYS_COL_PORT->BSRRL, (uint32_t)columnPattern,
+      DMA_DIR_MemoryToPeripheral);
+  KEYS_HAL_InitStream(KEYS_ROW_STREAM, KEYS_ROW_CHANNEL,
+      (uint32_t)&KEYS_ROW_PORT->IDR, (uint32_t)rowSnapshot,
+      DMA_DIR_PeripheralToMemory);
+
+  TIM_DMACmd(KEYS_SCAN_TIMER, TIM_DMA_Update | TIM_DMA_CC1, ENABLE);
+
+  // select first column now, so compare in first period reads column 0
+  TIM_GenerateEvent(KEYS_SCAN_TIMER, TIM_EventSource_Update);
+
+  TIM_Cmd(KEYS_SCAN_TIMER, ENABLE);
+}
+/**
+ * @brief Stop background scanning.
+ * @details Columns are left as they were - select all columns
+ * before waiting for edges.
+ */
+void KEYS_HAL_StopScan(void) {
+
+  TIM_Cmd(KEYS_SCAN_TIMER, DISABLE);
+  TIM_DMACmd(KEYS_SCAN_TIMER, TIM_DMA_Update | TIM_DMA_CC1, DISABLE);
+
+  DMA_Cmd(KEYS_COL_STREAM, DISABLE);
+  DMA_Cmd(KEYS_ROW_STREAM, DISABLE);
+
+  // wait for transfers to finish
+  while (DMA_GetCmdStatus(KEYS_COL_STREAM) == ENABLE ||
+      DMA_GetCmdStatus(KEYS_ROW_STREAM) == ENABLE);
+}
+/**
+ * @brief Read the result of background scan.
+ * @details Snapshot is updated by DMA, a column at a time, so
+ * columns may come from consecutive scans.
+ * @return Bitmap of pressed keys (bit column * 4 + row)
+ */
+uint16_t KEYS_HAL_ReadMatrix(void) {
+
+  uint16_t keys = 0;
+  uint8_t i;
+
+  for (i = 0; i < KEYS_HAL_COLUMNS; i++) {
+    uint16_t rows = (~rowSnapshot[i] & KEYS_ROW_PINS) >> KEYS_ROW_SHIFT;
+    keys |= rows << (i * KEYS_HAL_ROWS);
+  }
+
+  return keys;
+}
+/**
+ * @brief Drive all columns low.
+ * @details Any pressed key pulls its row low, so one edge
+ * interrupt covers the whole keyboard.
+ */
+void KEYS_HAL_SelectAllColumns(void) {
+
+  GPIO_ResetBits(KEYS_COL_PORT, KEYS_COL_PINS);
+}
+/**
+ * @brief Enable row edge interrupts.
+ * @details Edges from before (e.g. from scanning) are cleared.
+ */
+void KEYS_HAL_EnableEdgeIrq(void) {
+
+  EXTI_ClearITPendingBit(KEYS_EXTI_LINES);
+  EXTI->IMR |= KEYS_EXTI_LINES;
+}
+/**
+ * @brief Disable row edge interrupts.
+ */
+void KEYS_HAL_DisableEdgeIrq(void) {
+
+  EXTI->IMR &= ~KEYS_EXTI_LINES;
 }
 /**
- * @brief Read keyboard row.
- * @return Row value
+ * @brief IRQ handler for EXTI lines 10 to 15 (keyboard rows)
  */
-int8_t KEYS_HAL_ReadRow(void) {
+void EXTI15_10_IRQHandler(void) {
+
+  if (EXTI->PR & KEYS_EXTI_LINES) {
+
+    // one edge is enough - keyboard is scanned from now on
+    KEYS_HAL_DisableEdgeIrq();
+    EXTI_ClearITPendingBit(KEYS_EXTI_LINES);
 
-  uint16_t row_p = (GPIO_ReadInputData(KEYS_ROW_PORT)); // read row
-  uint16_t row = ~row_p; // negate, because we use low level for keypress
+    if (edgeCallback) {
+      edgeCallback();
+    }
+  }
+}
+/**
+ * @brief Read keyboard rows.
+ * @details Reads all rows at once. With all columns selected
+ * tells if any key is pressed.
+ * @return Bitmap of active rows (bit 0 is row 0)
+ */
+uint8_t KEYS_HAL_ReadRows(void) {
 
-  if (row & KEYS_ROW0_PIN)
-    return 0;
-  if (row & KEYS_ROW1_PIN)
-    return 1;
-  if (row & KEYS_ROW2_PIN)
-    return 2;
-  if (row & KEYS_ROW3_PIN)
-    return 3;
+  uint16_t row = ~GPIO_ReadInputData(KEYS_ROW_PORT); // low level for keypress
 
-  return -1;
+  return (row & KEYS_ROW_PINS) >> KEYS_ROW_SHIFT;
 }
@@ -72,27 +72,43 @@ void LED_HAL_Init(uint8_t led) {
 }
 
 /**
- * @brief Toggle an LED.
- * @param led LED number.
+ * @brief Write LED pins.
+ * @details All pins on a port change with one BSRR write, so
+ * other pins of the port are not touched (no ODR read-modify-write).
+ * @param on Bitmap of LEDs to light up
+ * @param off Bitmap of LEDs to turn off
  */
-void LED_HAL_Toggle(uint8_t led) {
-
-  ledPort[led]->ODR ^= ledPin[led]; // toggle bit
-}
-
-/**
- * @brief Change the state of an LED.
- * @param led LED number.
- * @param state New state.
- */
-void LED_HAL_ChangeState(uint8_t led, uint8_t state) {
-
-  if (state == 1) {
-    ledPort[led]->BSRRL = ledPin[led]; // set bit
-  } else {
-    ledPort[led]->BSRRH = ledPin[led]; // reset bit
+void LED_HAL_Write(uint32_t on, uint32_t off) {
+
+  uint32_t leds = (on | off) & ((1 << MAX_LEDS) - 1);
+  GPIO_TypeDef* port[MAX_LEDS];   // distinct ports of changed LEDs
+  uint32_t bsrr[MAX_LEDS];        // set bits in low half, reset bits in high half
+  uint8_t ports = 0;
+  uint8_t i;
+
+  // gather one BSRR word per port
+  while (leds) {
+    uint8_t led = __builtin_ctz(leds);
+    leds &= leds - 1;
+
+    for (i = 0; i < ports && port[i] != ledPort[led]; i++);
+
+    if (i == ports) {
+      port[ports] = ledPort[led];
+      bsrr[ports] = 0;
+      ports++;
+    }
+
+    if (on & (1 << led)) {
+      bsrr[i] |= ledPin[led];
+    } else {
+      bsrr[i] |= ledPin[led] << 16;
+    }
   }
 
+  for (i = 0; i < ports; i++) {
+    *(__IO uint32_t*)&port[i]->BSRRL = bsrr[i];
+  }
 }
 
 /**
@@ -0,0 +1,206 @@
+/**
+ * @file:   ledpwm_hal.c
+ * @brief:  HAL - LED brightness control with timer PWM
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <ledpwm_hal.h>
+#include <clocks.h>
+#include <stm32f4xx.h>
+
+/**
+ * @addtogroup LEDPWM_HAL
+ * @{
+ */
+
+/*
+ * LEDs on PD12-PD15 are TIM4 channels 1-4. On every update event
+ * the channel 1 DMA request (CCDS set) starts a DMA burst writing
+ * the next frame of the compare table to CCR1-CCR4 through DMAR.
+ * Compare registers are preloaded, so a frame is applied at the
+ * start of the following PWM period.
+ */
+#define LEDPWM_TIMER        TIM4
+#define LEDPWM_TIMER_CLOCK  RCC_APB1Periph_TIM4
+#define LEDPWM_PORT         GPIOD
+#define LEDPWM_PORT_CLOCK   RCC_AHB1Periph_GPIOD
+#define LEDPWM_AF           GPIO_AF_TIM4
+#define LEDPWM_DMA_CLOCK    RCC_AHB1Periph_DMA1
+#define LEDPWM_STREAM       DMA1_Stream0  ///< TIM4_CH1
+#define LEDPWM_CHANNEL      DMA_Channel_2
+#define LEDPWM_IRQ          DMA1_Stream0_IRQn
+
+/**
+ * @brief Compare table - two halves of LEDPWM_HAL_FRAMES frames,
+ * one compare value per channel in each frame.
+ */
+static uint16_t compareTable[2 * LEDPWM_HAL_FRAMES * LEDPWM_HAL_CHANNELS];
+
+static void (*fillCallback)(uint16_t*, uint16_t); ///< Fills frames of table
+
+/**
+ * @brief LED pins (TIM4 channels)
+ */
+static const uint16_t pwmPin[LEDPWM_HAL_CHANNELS] = {
+    GPIO_Pin_12,
+    GPIO_Pin_13,
+    GPIO_Pin_14,
+    GPIO_Pin_15};
+/**
+ * @brief LED pin sources (for alternate function mapping)
+ */
+static const uint8_t pwmPinSource[LEDPWM_HAL_CHANNELS] = {
+    GPIO_PinSource12,
+    GPIO_PinSource13,
+    GPIO_PinSource14,
+    GPIO_PinSource15};
+
+/**
+ * @brief Calculate prescaler giving a frame every LEDPWM_HAL_FRAME_TIME
+ * @return Prescaler value for current timer clock
+ */
+static uint16_t LEDPWM_HAL_GetPrescaler(void) {
+
+  uint32_t div = CLOCKS_GetAPB1TimerFreq() / (1000 / LEDPWM_HAL_FRAME_TIME) /
+      LEDPWM_HAL_MAX_LEVEL;
+
+  return div ? div - 1 : 0; // frames get longer at very low clocks
+}
+/**
+ * @brief Initialize PWM and start playing the compare table.
+ * @details Both halves of the table are filled before starting,
+ * afterwards each half is refilled (in interrupt) once it has
+ * been sent. Pins are connected to the timer with
+ * LEDPWM_HAL_EnableOutput.
+ * @param fillCb Function filling count frames starting at frames
+ */
+void LEDPWM_HAL_Init(void (*fillCb)(uint16_t* frames, uint16_t count)) {
+
+  fillCallback = fillCb;
+
+  fillCallback(compareTable, 2 * LEDPWM_HAL_FRAMES);
+
+  RCC_APB1PeriphClockCmd(LEDPWM_TIMER_CLOCK, ENABLE);
+  RCC_AHB1PeriphClockCmd(LEDPWM_DMA_CLOCK, ENABLE);
+
+  // compare value LEDPWM_HAL_MAX_LEVEL is above period - always on
+  TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+  TIM_TimeBaseStructure.TIM_Prescaler = LEDPWM_HAL_GetPrescaler();
+  TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+  TIM_TimeBaseStructure.TIM_Period = LEDPWM_HAL_MAX_LEVEL - 1;
+  TIM_TimeBaseStructure.TIM_ClockDivision = 0;
+  TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+  TIM_TimeBaseInit(LEDPWM_TIMER, &TIM_TimeBaseStructure);
+
+  TIM_OCInitTypeDef TIM_OCInitStructure;
+  TIM_OCStructInit(&TIM_OCInitStructure);
+  TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_PWM1;
+  TIM_OCInitStructure.TIM_OutputState = TIM_OutputState_Enable;
+  TIM_OCInitStructure.TIM_OCPolarity = TIM_OCPolarity_High;
+  TIM_OCInitStructure.TIM_Pulse = 0;
+  TIM_OC1Init(LEDPWM_TIMER, &TIM_OCInitStructure);
+  TIM_OC2Init(LEDPWM_TIMER, &TIM_OCInitStructure);
+  TIM_OC3Init(LEDPWM_TIMER, &TIM_OCInitStructure);
+  TIM_OC4Init(LEDPWM_TIMER, &TIM_OCInitStructure);
+  TIM_OC1PreloadConfig(LEDPWM_TIMER, TIM_OCPreload_Enable);
+  TIM_OC2PreloadConfig(LEDPWM_TIMER, TIM_OCPreload_Enable);
+  TIM_OC3PreloadConfig(LEDPWM_TIMER, TIM_OCPreload_Enable);
+  TIM_OC4PreloadConfig(LEDPWM_TIMER, TIM_OCPreload_Enable);
+  TIM_ARRPreloadConfig(LEDPWM_TIMER, ENABLE);
+
+  // circular DMA of whole table to DMAR, half and full transfer interrupts
+  DMA_InitTypeDef DMA_InitStructure;
+  DMA_DeInit(LEDPWM_STREAM);
+  DMA_StructInit(&DMA_InitStructure);
+  DMA_InitStructure.DMA_Channel             = LEDPWM_CHANNEL;
+  DMA_InitStructure.DMA_PeripheralBaseAddr  = (uint32_t)&LEDPWM_TIMER->DMAR;
+  DMA_InitStructure.DMA_Memory0BaseAddr     = (uint32_t)compareTable;
+  DMA_InitStructure.DMA_DIR                 = DMA_DIR_MemoryToPeripheral;
+  DMA_InitStructure.DMA_BufferSize          = sizeof(compareTable) / sizeof(compareTable[0]);
+  DMA_InitStructure.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
+  DMA_InitStructure.DMA_MemoryInc           = DMA_MemoryInc_Enable;
+  DMA_InitStructure.DMA_PeripheralDataSize  = DMA_PeripheralDataSize_HalfWord;
+  DMA_InitStructure.DMA_MemoryDataSize      = DMA_MemoryDataSize_HalfWord;
+  DMA_InitStructure.DMA_Mode                = DMA_Mode_Circular;
+  DMA_InitStructure.DMA_Priority            = DMA_Priority_Low;
+  DMA_Init(LEDPWM_STREAM, &DMA_InitStructure);
+  DMA_ITConfig(LEDPWM_STREAM, DMA_IT_HT | DMA_IT_TC, ENABLE);
+
+  NVIC_InitTypeDef NVIC_InitStructure;
+  NVIC_InitStructure.NVIC_IRQChannel = LEDPWM_IRQ;
+  NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 0;
+  NVIC_InitStructure.NVIC_IRQChannelSubPriority = 3;
+  NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+  NVIC_Init(&NVIC_InitStructure);
+
+  DMA_Cmd(LEDPWM_STREAM, ENABLE);
+
+  // each update writes CCR1-CCR4 in one burst
+  TIM_DMAConfig(LEDPWM_TIMER, TIM_DMABase_CCR1, TIM_DMABurstLength_4Transfers);
+  TIM_SelectCCDMA(LEDPWM_TIMER, ENABLE);
+  TIM_DMACmd(LEDPWM_TIMER, TIM_DMA_CC1, ENABLE);
+
+  TIM_Cmd(LEDPWM_TIMER, ENABLE);
+}
+/**
+ * @brief Connect LED pin to its PWM channel.
+ * @details The pin is no longer controlled as a GPIO.
+ * @param channel Channel number (LED number)
+ */
+void LEDPWM_HAL_EnableOutput(uint8_t channel) {
+
+  RCC_AHB1PeriphClockCmd(LEDPWM_PORT_CLOCK, ENABLE);
+
+  GPIO_InitTypeDef GPIO_InitStructure;
+
+  GPIO_InitStructure.GPIO_Pin   = pwmPin[channel];
+  GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_AF;     // timer output
+  GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;    // push-pull output
+  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_2MHz;  // less interference
+  GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_NOPULL; // no pull-up
+
+  GPIO_Init(LEDPWM_PORT, &GPIO_InitStructure);
+  GPIO_PinAFConfig(LEDPWM_PORT, pwmPinSource[channel], LEDPWM_AF);
+}
+/**
+ * @brief Recalculate prescaler after APB1 clock change.
+ * @details The prescaler is preloaded, so the change takes
+ * effect on the next update without a glitch.
+ */
+void LEDPWM_HAL_UpdateClock(void) {
+
+  TIM_PrescalerConfig(LEDPWM_TIMER, LEDPWM_HAL_GetPrescaler(), TIM_PSCReloadMode_Update);
+}
+/**
+ * @brief IRQ handler for DMA1 stream 0 (LED compare table)
+ * @details Refills the half of the table that was just sent,
+ * while the other half is being sent.
+ */
+void DMA1_Stream0_IRQHandler(void) {
+
+  if (DMA_GetITStatus(LEDPWM_STREAM, DMA_IT_HTIF0)) {
+    DMA_ClearITPendingBit(LEDPWM_STREAM, DMA_IT_HTIF0);
+    fillCallback(compareTable, LEDPWM_HAL_FRAMES);
+  }
+
+  if (DMA_GetITStatus(LEDPWM_STREAM, DMA_IT_TCIF0)) {
+    DMA_ClearITPendingBit(LEDPWM_STREAM, DMA_IT_TCIF0);
+    fillCallback(&compareTable[LEDPWM_HAL_FRAMES * LEDPWM_HAL_CHANNELS],
+        LEDPWM_HAL_FRAMES);
+  }
+}
+
+/**
+ * @}
+ */
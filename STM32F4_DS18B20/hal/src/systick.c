@@ -16,6 +16,7 @@
  */
 
 #include <systick.h>
+#include <clocks.h>
 #include <stm32f4xx.h>
 
 /**
@@ -29,6 +30,7 @@
  */
 
 static volatile uint32_t sysTicks;  ///< Delay timer.
+static uint32_t sysTickFreq;        ///< SysTick frequency
 
 /**
  * @brief Initialize the SysTick with a given frequency
@@ -36,12 +38,27 @@ static volatile uint32_t sysTicks;  ///< Delay timer.
  */
 void SYSTICK_Init(uint32_t freq) {
 
-  RCC_ClocksTypeDef RCC_Clocks;
+  sysTickFreq = freq;
 
-  RCC_GetClocksFreq(&RCC_Clocks); // Complete the clocks structure with current clock settings.
+  SysTick_Config(CLOCKS_GetHCLKFreq() / freq); // Set SysTick frequency
 
-  SysTick_Config(RCC_Clocks.HCLK_Frequency / freq); // Set SysTick frequency
+}
+/**
+ * @brief Recalculate SysTick reload value after HCLK change.
+ * @details System time is not changed.
+ */
+void SYSTICK_UpdateClock(void) {
+
+  SysTick_Config(CLOCKS_GetHCLKFreq() / sysTickFreq);
+}
+/**
+ * @brief Put the core to sleep until next interrupt.
+ * @details SysTick interrupt wakes the core at least
+ * once every tick.
+ */
+void SYSTICK_Sleep(void) {
 
+  __WFI();
 }
 /**
  * @brief Get the system time
@@ -17,24 +17,43 @@
 
 #include <stm32f4xx.h>
 #include <timer14.h>
+#include <clocks.h>
+#include <critical.h>
 
-static volatile uint32_t usCount; ///< Microsecond counter
+static volatile uint32_t usHigh; ///< Upper half of microsecond count (counter overflows)
+
+/**
+ * @brief Calculate prescaler giving 1 MHz count
+ * @details Below 1 MHz timer clock the timer counts at the timer clock.
+ * @return Prescaler value for current timer clock
+ */
+static uint16_t TIMER14_GetPrescaler(void) {
+
+  uint32_t div = CLOCKS_GetAPB1TimerFreq() / 1000000;
+
+  return div ? div - 1 : 0;
+}
 
 /**
  * @brief Initialize timer14 as microsecond counter
+ * @details The 16 bit counter counts microseconds, the
+ * overflow interrupt (every 65.536 ms) extends it to 32 bits.
  */
 void TIMER14_Init(void) {
 
   RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM14, ENABLE);
 
   TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
-  TIM_TimeBaseStructure.TIM_Prescaler = 0;
+  TIM_TimeBaseStructure.TIM_Prescaler = TIMER14_GetPrescaler(); // 1 MHz count
   TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
-  TIM_TimeBaseStructure.TIM_Period = 84; // overflow every microsecond
+  TIM_TimeBaseStructure.TIM_Period = 0xffff; // full 16 bit range
   TIM_TimeBaseStructure.TIM_ClockDivision = 0;
   TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
   TIM_TimeBaseInit(TIM14, &TIM_TimeBaseStructure);
 
+  TIM_ClearFlag(TIM14, TIM_FLAG_Update); // set by prescaler load in init
+  TIM_UpdateRequestConfig(TIM14, TIM_UpdateSource_Regular); // only overflows set the flag
+
   // initialize interrupt
   NVIC_InitTypeDef NVIC_InitStructure;
   NVIC_InitStructure.NVIC_IRQChannel = TIM8_TRG_COM_TIM14_IRQn;
@@ -47,14 +66,42 @@ void TIMER14_Init(void) {
 
   TIM_Cmd(TIM14, ENABLE); // enable timer
 }
+/**
+ * @brief Recalculate prescaler after APB1 clock change.
+ * @details The new prescaler is loaded with an update event,
+ * which zeroes the counter, so the count is restored right
+ * after. The event doesn't count as an overflow.
+ */
+void TIMER14_UpdateClock(void) {
+
+  uint32_t lock = CRITICAL_Enter();
+
+  uint16_t count = TIM14->CNT;
+  TIM_PrescalerConfig(TIM14, TIMER14_GetPrescaler(), TIM_PSCReloadMode_Immediate);
+  TIM14->CNT = count;
+
+  CRITICAL_Exit(lock);
+}
 /**
  * @brief Get time value
  * @return Time in microseconds
  */
 uint32_t TIMER14_GetTime(void) {
 
-  return usCount;
+  uint32_t lock = CRITICAL_Enter();
+
+  uint32_t high = usHigh;
+  uint16_t count = TIM14->CNT;
+
+  // overflow not handled yet (called with interrupts blocked)
+  if (TIM_GetFlagStatus(TIM14, TIM_FLAG_Update) != RESET) {
+    count = TIM14->CNT; // count after the overflow
+    high += 0x10000;
+  }
+
+  CRITICAL_Exit(lock);
 
+  return high | count;
 }
 /**
  * @brief IRQ handler for TIM14
@@ -64,8 +111,8 @@ void TIM8_TRG_COM_TIM14_IRQHandler(void) {
   if((TIM_GetFlagStatus(TIM14, TIM_FLAG_Update) != RESET)) {
     // clear flag
     TIM_ClearFlag(TIM14, TIM_FLAG_Update);
-    // update microsecond count
-    usCount++;
+    // update upper half of microsecond count
+    usHigh += 0x10000;
   }
 }
 
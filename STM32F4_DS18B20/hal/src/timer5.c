@@ -0,0 +1,166 @@
+/**
+ * @file:   timer5.c
+ * @brief:  TIMER5 compare channels as microsecond alarms
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @details TIMER5 is a 32 bit timer running freely at 1 MHz.
+ * Each of its four capture/compare channels can be armed
+ * to generate an interrupt at a given microsecond time.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <timer5.h>
+#include <clocks.h>
+#include <critical.h>
+#include <stm32f4xx.h>
+
+/**
+ * @addtogroup TIMER5
+ * @{
+ */
+
+static void (*compareCallback)(uint8_t); ///< Callback for compare events
+
+/**
+ * @brief Compare interrupt flags for each channel
+ */
+static const uint16_t channelIt[TIMER5_CHANNELS] = {
+    TIM_IT_CC1,
+    TIM_IT_CC2,
+    TIM_IT_CC3,
+    TIM_IT_CC4};
+
+/**
+ * @brief Calculate prescaler giving 1 MHz count
+ * @details Below 1 MHz timer clock the timer counts at the timer clock.
+ * @return Prescaler value for current timer clock
+ */
+static uint16_t TIMER5_GetPrescaler(void) {
+
+  uint32_t div = CLOCKS_GetAPB1TimerFreq() / 1000000;
+
+  return div ? div - 1 : 0;
+}
+/**
+ * @brief Initialize TIMER5 as free running microsecond counter
+ * @param compareCb Callback called (in interrupt) with channel number
+ * when the compare time of channel is reached
+ */
+void TIMER5_Init(void(*compareCb)(uint8_t)) {
+
+  compareCallback = compareCb;
+
+  RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM5, ENABLE);
+
+  TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+  TIM_TimeBaseStructure.TIM_Prescaler = TIMER5_GetPrescaler(); // 1 MHz count
+  TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+  TIM_TimeBaseStructure.TIM_Period = 0xffffffff; // full 32 bit range
+  TIM_TimeBaseStructure.TIM_ClockDivision = 0;
+  TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+  TIM_TimeBaseInit(TIM5, &TIM_TimeBaseStructure);
+
+  // compare channels only set flags - no output pins
+  TIM_OCInitTypeDef TIM_OCInitStructure;
+  TIM_OCStructInit(&TIM_OCInitStructure);
+  TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_Timing;
+  TIM_OC1Init(TIM5, &TIM_OCInitStructure);
+  TIM_OC2Init(TIM5, &TIM_OCInitStructure);
+  TIM_OC3Init(TIM5, &TIM_OCInitStructure);
+  TIM_OC4Init(TIM5, &TIM_OCInitStructure);
+
+  // initialize interrupt
+  NVIC_InitTypeDef NVIC_InitStructure;
+  NVIC_InitStructure.NVIC_IRQChannel = TIM5_IRQn;
+  NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 0;
+  NVIC_InitStructure.NVIC_IRQChannelSubPriority = 2;
+  NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+  NVIC_Init(&NVIC_InitStructure);
+
+  TIM_Cmd(TIM5, ENABLE); // enable timer
+}
+/**
+ * @brief Recalculate prescaler after APB1 clock change.
+ * @details The new prescaler is loaded with an update event,
+ * which zeroes the counter, so the count is restored right
+ * after. Time lost during the update is below a microsecond.
+ */
+void TIMER5_UpdateClock(void) {
+
+  uint32_t lock = CRITICAL_Enter();
+
+  uint32_t count = TIM5->CNT;
+  TIM_PrescalerConfig(TIM5, TIMER5_GetPrescaler(), TIM_PSCReloadMode_Immediate);
+  TIM5->CNT = count;
+
+  CRITICAL_Exit(lock);
+}
+/**
+ * @brief Get time value
+ * @return Time in microseconds
+ */
+uint32_t TIMER5_GetTime(void) {
+
+  return TIM5->CNT;
+}
+/**
+ * @brief Arm a compare channel.
+ * @details If the time has already passed, the compare
+ * event is generated immediately.
+ * @param ch Channel number (0-3)
+ * @param time Time of compare event in microseconds
+ */
+void TIMER5_SetCompare(uint8_t ch, uint32_t time) {
+
+  // CCR1-CCR4 are consecutive registers
+  (&TIM5->CCR1)[ch] = time;
+  TIM_ClearITPendingBit(TIM5, channelIt[ch]);
+  TIM_ITConfig(TIM5, channelIt[ch], ENABLE);
+
+  // the counter could have already passed the compare value
+  if ((int32_t)(time - TIM5->CNT) <= 0) {
+    TIM_GenerateEvent(TIM5, channelIt[ch]); // event source bits match IT bits
+  }
+}
+/**
+ * @brief Disarm a compare channel.
+ * @param ch Channel number (0-3)
+ */
+void TIMER5_DisableCompare(uint8_t ch) {
+
+  TIM_ITConfig(TIM5, channelIt[ch], DISABLE);
+  TIM_ClearITPendingBit(TIM5, channelIt[ch]);
+}
+/**
+ * @brief IRQ handler for TIM5
+ */
+void TIM5_IRQHandler(void) {
+
+  uint8_t ch;
+
+  for (ch = 0; ch < TIMER5_CHANNELS; ch++) {
+
+    if (TIM_GetITStatus(TIM5, channelIt[ch]) != RESET) {
+      // one shot - disarm channel before calling higher layer
+      TIMER5_DisableCompare(ch);
+
+      if (compareCallback) { // if not NULL
+        compareCallback(ch);
+      }
+    }
+  }
+}
+
+/**
+ * @}
+ */
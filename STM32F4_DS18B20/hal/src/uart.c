@@ -0,0 +1,568 @@
+/**
+ * @file:   uart.c
+ * @brief:  Controlling UART
+ * @date:   12 kwi 2014
+ * @author: Michal Ksiezopolski
+ * 
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the 
+ * accompanying materials are made available 
+ * under the terms of the GNU Public License 
+ * v3.0 which accompanies this distribution, 
+ * and is available at 
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <uart.h>
+#include <critical.h>
+#include <clocks.h>
+#include <stm32f4xx.h>
+
+/**
+ * @addtogroup UART
+ * @{
+ */
+
+#define UART_RX_BUF_LEN 256 ///< Length of circular DMA receive buffer
+
+/**
+ * @brief Port hardware description.
+ */
+typedef struct {
+  USART_TypeDef* usart;         ///< USART peripheral
+  uint32_t usartClock;          ///< USART clock
+  uint8_t apb2;                 ///< Nonzero - USART on APB2 (else APB1)
+  GPIO_TypeDef* gpio;           ///< TX and RX port
+  uint32_t gpioClock;           ///< Port clock
+  uint16_t txPin;               ///< TX pin
+  uint16_t rxPin;               ///< RX pin
+  uint8_t txSource;             ///< TX pin source
+  uint8_t rxSource;             ///< RX pin source
+  uint8_t af;                   ///< Alternate function
+  uint32_t dmaClock;            ///< DMA clock
+  DMA_Stream_TypeDef* txStream; ///< TX DMA stream
+  DMA_Stream_TypeDef* rxStream; ///< RX DMA stream
+  uint32_t dmaChannel;          ///< DMA channel (same for TX and RX)
+  uint32_t txFlags;             ///< All TX stream flags
+  uint32_t txTcIt;              ///< TX stream transfer complete interrupt
+  uint32_t rxHtIt;              ///< RX stream half transfer interrupt
+  uint32_t rxTcIt;              ///< RX stream transfer complete interrupt
+  IRQn_Type usartIrq;           ///< USART interrupt
+  IRQn_Type txIrq;              ///< TX DMA stream interrupt
+  IRQn_Type rxIrq;              ///< RX DMA stream interrupt
+} UART_Hw_TypeDef;
+
+/**
+ * @brief Hardware of ports
+ */
+static const UART_Hw_TypeDef uartHw[UART_PORTS] = {
+    { // USART1 - TX DMA2 Stream7, RX DMA2 Stream2, channel 4
+        USART1, RCC_APB2Periph_USART1, 1,
+        GPIOA, RCC_AHB1Periph_GPIOA, GPIO_Pin_9, GPIO_Pin_10,
+        GPIO_PinSource9, GPIO_PinSource10, GPIO_AF_USART1,
+        RCC_AHB1Periph_DMA2, DMA2_Stream7, DMA2_Stream2, DMA_Channel_4,
+        DMA_FLAG_TCIF7 | DMA_FLAG_HTIF7 | DMA_FLAG_TEIF7 | DMA_FLAG_DMEIF7 | DMA_FLAG_FEIF7,
+        DMA_IT_TCIF7, DMA_IT_HTIF2, DMA_IT_TCIF2,
+        USART1_IRQn, DMA2_Stream7_IRQn, DMA2_Stream2_IRQn},
+    { // USART2 - TX DMA1 Stream6, RX DMA1 Stream5, channel 4
+        USART2, RCC_APB1Periph_USART2, 0,
+        GPIOA, RCC_AHB1Periph_GPIOA, GPIO_Pin_2, GPIO_Pin_3,
+        GPIO_PinSource2, GPIO_PinSource3, GPIO_AF_USART2,
+        RCC_AHB1Periph_DMA1, DMA1_Stream6, DMA1_Stream5, DMA_Channel_4,
+        DMA_FLAG_TCIF6 | DMA_FLAG_HTIF6 | DMA_FLAG_TEIF6 | DMA_FLAG_DMEIF6 | DMA_FLAG_FEIF6,
+        DMA_IT_TCIF6, DMA_IT_HTIF5, DMA_IT_TCIF5,
+        USART2_IRQn, DMA1_Stream6_IRQn, DMA1_Stream5_IRQn},
+    { // USART3 - TX DMA1 Stream3, RX DMA1 Stream1, channel 4
+        USART3, RCC_APB1Periph_USART3, 0,
+        GPIOB, RCC_AHB1Periph_GPIOB, GPIO_Pin_10, GPIO_Pin_11,
+        GPIO_PinSource10, GPIO_PinSource11, GPIO_AF_USART3,
+        RCC_AHB1Periph_DMA1, DMA1_Stream3, DMA1_Stream1, DMA_Channel_4,
+        DMA_FLAG_TCIF3 | DMA_FLAG_HTIF3 | DMA_FLAG_TEIF3 | DMA_FLAG_DMEIF3 | DMA_FLAG_FEIF3,
+        DMA_IT_TCIF3, DMA_IT_HTIF1, DMA_IT_TCIF1,
+        USART3_IRQn, DMA1_Stream3_IRQn, DMA1_Stream1_IRQn},
+    { // USART6 - TX DMA2 Stream6, RX DMA2 Stream1, channel 5
+        USART6, RCC_APB2Periph_USART6, 1,
+        GPIOC, RCC_AHB1Periph_GPIOC, GPIO_Pin_6, GPIO_Pin_7,
+        GPIO_PinSource6, GPIO_PinSource7, GPIO_AF_USART6,
+        RCC_AHB1Periph_DMA2, DMA2_Stream6, DMA2_Stream1, DMA_Channel_5,
+        DMA_FLAG_TCIF6 | DMA_FLAG_HTIF6 | DMA_FLAG_TEIF6 | DMA_FLAG_DMEIF6 | DMA_FLAG_FEIF6,
+        DMA_IT_TCIF6, DMA_IT_HTIF1, DMA_IT_TCIF1,
+        USART6_IRQn, DMA2_Stream6_IRQn, DMA2_Stream1_IRQn},
+};
+
+/**
+ * @brief Port state.
+ */
+typedef struct {
+  void*     ctx;                            ///< Context passed to callbacks
+  void      (*rxCallback)(void*, uint8_t*, uint16_t);  ///< Callback function for receiving data
+  uint16_t  (*txCallback)(void*, uint16_t, uint8_t**); ///< Callback function for transmitting data
+  volatile uint16_t txLen;                  ///< Length of DMA transfer in progress (0 - transmitter idle)
+  uint16_t  rxPos;                          ///< Position in rxBuffer up to which data was passed to higher layer
+  uint8_t   rxBuffer[UART_RX_BUF_LEN];      ///< Circular DMA receive buffer
+  uint32_t  baud;                           ///< Required baud rate (kept for clock changes)
+  uint32_t  achieved;                       ///< Baud rate achieved with current clock
+} UART_State_TypeDef;
+
+static UART_State_TypeDef uartState[UART_PORTS]; ///< State of ports
+
+/**
+ * @brief Calculates baud rate register.
+ * @details USARTDIV is set in 1/16 steps with 16x oversampling
+ * and in 1/8 steps with 8x oversampling, so the divider from
+ * the peripheral clock is the same. 8x oversampling is used only
+ * when it gives a smaller error, i.e. for rates above PCLK/16,
+ * since 16x oversampling is more tolerant to noise.
+ * @param pclk Peripheral clock frequency in Hz
+ * @param baud Required baud rate
+ * @param over8 Set if 8x oversampling should be used
+ * @param brr Baud rate register value
+ * @return Achieved baud rate
+ */
+static uint32_t UART_CalcBrr(uint32_t pclk, uint32_t baud, uint8_t* over8, uint16_t* brr) {
+
+  // rounded divider of peripheral clock
+  uint32_t div = (pclk + baud / 2) / baud;
+
+  // limits of 12 bit mantissa and 4 (3) bit fraction
+  uint32_t div16 = div < 16 ? 16 : (div > 0xffff ? 0xffff : div);
+  uint32_t div8  = div < 8  ? 8  : (div > 0x7fff ? 0x7fff : div);
+
+  uint32_t err16 = (div16 > div) ? div16 - div : div - div16;
+  uint32_t err8  = (div8 > div)  ? div8 - div  : div - div8;
+
+  if (err8 < err16) {
+    *over8 = 1;
+    *brr = ((div8 & ~0x7) << 1) | (div8 & 0x7); // fraction on 3 bits
+    return pclk / div8;
+  }
+
+  *over8 = 0;
+  *brr = div16;
+  return pclk / div16;
+}
+/**
+ * @brief Get peripheral clock of port.
+ * @param port Port number
+ * @return Clock frequency in Hz
+ */
+static uint32_t UART_GetClock(uint8_t port) {
+
+  if (uartHw[port].apb2) {
+    return CLOCKS_GetPCLK2Freq();
+  }
+
+  return CLOCKS_GetPCLK1Freq();
+}
+/**
+ * @brief Sets baud rate register and oversampling of port.
+ * @details The USART is disabled for the change.
+ * @param port Port number
+ */
+static void UART_ApplyBaud(uint8_t port) {
+
+  USART_TypeDef* usart = uartHw[port].usart;
+  UART_State_TypeDef* state = &uartState[port];
+  uint8_t over8;
+  uint16_t brr;
+  uint16_t enabled = usart->CR1 & USART_CR1_UE;
+
+  state->achieved = UART_CalcBrr(UART_GetClock(port), state->baud, &over8, &brr);
+
+  usart->CR1 &= ~USART_CR1_UE;
+
+  if (over8) {
+    usart->CR1 |= USART_CR1_OVER8;
+  } else {
+    usart->CR1 &= ~USART_CR1_OVER8;
+  }
+  usart->BRR = brr;
+
+  usart->CR1 |= enabled;
+}
+/**
+ * @brief Calculates baud rate which would be achieved on port.
+ * @param port Port number
+ * @param baud Required baud rate
+ * @return Achieved baud rate
+ */
+uint32_t UART_CalcBaud(uint8_t port, uint32_t baud) {
+
+  uint8_t over8;
+  uint16_t brr;
+
+  return UART_CalcBrr(UART_GetClock(port), baud, &over8, &brr);
+}
+/**
+ * @brief Changes baud rate of port.
+ * @details Waits until the last character queued for DMA is sent.
+ * Rates up to PCLK/8 can be set (10.5 Mbaud on USART1/6 and
+ * 5.25 Mbaud on USART2/3 with 168 MHz core clock).
+ * @param port Port number
+ * @param baud Required baud rate
+ * @return Achieved baud rate
+ */
+uint32_t UART_SetBaud(uint8_t port, uint32_t baud) {
+
+  while (USART_GetFlagStatus(uartHw[port].usart, USART_FLAG_TC) == RESET);
+
+  uartState[port].baud = baud;
+  UART_ApplyBaud(port);
+
+  return uartState[port].achieved;
+}
+/**
+ * @brief Get achieved baud rate of port.
+ * @param port Port number
+ * @return Achieved baud rate
+ */
+uint32_t UART_GetBaud(uint8_t port) {
+
+  return uartState[port].achieved;
+}
+/**
+ * @brief Initialize a port
+ * @details Data is transmitted by DMA in spans given by the
+ * transmit callback. The callback gets the number of bytes
+ * sent from the previous span (to be freed) and returns the next
+ * contiguous span (0 - no more data).
+ *
+ * Data is received by DMA into a circular buffer. New data is
+ * passed to the receive callback in blocks, when the line
+ * goes idle and when the DMA reaches half and end of buffer.
+ *
+ * Every port has its own DMA streams and interrupts, so ports
+ * don't wait for each other. Callbacks run in interrupt context.
+ * @param port Port number (see UART_Port_TypeDef)
+ * @param baud Baud rate
+ * @param ctx Context passed to callbacks
+ * @param rxCb Receive callback
+ * @param txCb Transmit callback
+ */
+void UART_Init(uint8_t port, uint32_t baud, void* ctx,
+    void(*rxCb)(void*, uint8_t*, uint16_t), uint16_t(*txCb)(void*, uint16_t, uint8_t**)) {
+
+  const UART_Hw_TypeDef* hw = &uartHw[port];
+  UART_State_TypeDef* state = &uartState[port];
+
+  // assign the callbacks
+  state->ctx        = ctx;
+  state->rxCallback = rxCb;
+  state->txCallback = txCb;
+
+  GPIO_InitTypeDef  GPIO_InitStructure;
+  USART_InitTypeDef USART_InitStructure;
+
+  // Enable clocks for peripherals
+  if (hw->apb2) {
+    RCC_APB2PeriphClockCmd(hw->usartClock, ENABLE);
+  } else {
+    RCC_APB1PeriphClockCmd(hw->usartClock, ENABLE);
+  }
+  RCC_AHB1PeriphClockCmd(hw->gpioClock, ENABLE);
+  RCC_AHB1PeriphClockCmd(hw->dmaClock,  ENABLE);
+
+  // TX and RX pins
+  GPIO_InitStructure.GPIO_Pin   = hw->txPin | hw->rxPin;
+  GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_AF;
+  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+  GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
+  GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_UP;
+  GPIO_Init(hw->gpio, &GPIO_InitStructure);
+
+  // Connect pins to USART alternate function
+  GPIO_PinAFConfig(hw->gpio, hw->txSource, hw->af);
+  GPIO_PinAFConfig(hw->gpio, hw->rxSource, hw->af);
+
+  // USART initialization (standard 8n1)
+  USART_InitStructure.USART_BaudRate            = baud;
+  USART_InitStructure.USART_WordLength          = USART_WordLength_8b;
+  USART_InitStructure.USART_StopBits            = USART_StopBits_1;
+  USART_InitStructure.USART_Parity              = USART_Parity_No;
+  USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+  USART_InitStructure.USART_Mode                = USART_Mode_Rx | USART_Mode_Tx;
+  USART_Init(hw->usart, &USART_InitStructure);
+
+  // baud rate register with best oversampling
+  state->baud = baud;
+  UART_ApplyBaud(port);
+
+  // TX DMA stream - memory address and length are set for every transfer
+  DMA_InitTypeDef DMA_InitStructure;
+  DMA_DeInit(hw->txStream);
+  DMA_InitStructure.DMA_Channel             = hw->dmaChannel;
+  DMA_InitStructure.DMA_PeripheralBaseAddr  = (uint32_t)&hw->usart->DR;
+  DMA_InitStructure.DMA_Memory0BaseAddr     = 0;
+  DMA_InitStructure.DMA_DIR                 = DMA_DIR_MemoryToPeripheral;
+  DMA_InitStructure.DMA_BufferSize          = 1;
+  DMA_InitStructure.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
+  DMA_InitStructure.DMA_MemoryInc           = DMA_MemoryInc_Enable;
+  DMA_InitStructure.DMA_PeripheralDataSize  = DMA_PeripheralDataSize_Byte;
+  DMA_InitStructure.DMA_MemoryDataSize      = DMA_MemoryDataSize_Byte;
+  DMA_InitStructure.DMA_Mode                = DMA_Mode_Normal;
+  DMA_InitStructure.DMA_Priority            = DMA_Priority_Medium;
+  DMA_InitStructure.DMA_FIFOMode            = DMA_FIFOMode_Disable;
+  DMA_InitStructure.DMA_FIFOThreshold       = DMA_FIFOThreshold_Full;
+  DMA_InitStructure.DMA_MemoryBurst         = DMA_MemoryBurst_Single;
+  DMA_InitStructure.DMA_PeripheralBurst     = DMA_PeripheralBurst_Single;
+  DMA_Init(hw->txStream, &DMA_InitStructure);
+
+  DMA_ITConfig(hw->txStream, DMA_IT_TC, ENABLE);
+  USART_DMACmd(hw->usart, USART_DMAReq_Tx, ENABLE);
+
+  state->txLen = 0; // transmitter idle
+
+  // RX DMA stream - circular buffer
+  DMA_DeInit(hw->rxStream);
+  DMA_InitStructure.DMA_Memory0BaseAddr     = (uint32_t)state->rxBuffer;
+  DMA_InitStructure.DMA_DIR                 = DMA_DIR_PeripheralToMemory;
+  DMA_InitStructure.DMA_BufferSize          = UART_RX_BUF_LEN;
+  DMA_InitStructure.DMA_Mode                = DMA_Mode_Circular;
+  DMA_InitStructure.DMA_Priority            = DMA_Priority_High;
+  DMA_Init(hw->rxStream, &DMA_InitStructure);
+
+  DMA_ITConfig(hw->rxStream, DMA_IT_HT | DMA_IT_TC, ENABLE);
+  USART_DMACmd(hw->usart, USART_DMAReq_Rx, ENABLE);
+
+  state->rxPos = 0;
+  DMA_Cmd(hw->rxStream, ENABLE);
+
+  // Enable USART
+  USART_Cmd(hw->usart, ENABLE);
+
+  // Enable idle line interrupt - end of received block
+  USART_ITConfig(hw->usart, USART_IT_IDLE, ENABLE);
+
+  // Enable USART and DMA global interrupts
+  NVIC_EnableIRQ(hw->usartIrq);
+  NVIC_EnableIRQ(hw->rxIrq);
+  NVIC_EnableIRQ(hw->txIrq);
+
+}
+/**
+ * @brief Recalculate baud rate register after APB clock change.
+ * @details Waits until the last character queued for DMA is sent.
+ * @param port Port number
+ */
+void UART_UpdateClock(uint8_t port) {
+
+  while (USART_GetFlagStatus(uartHw[port].usart, USART_FLAG_TC) == RESET);
+
+  UART_ApplyBaud(port); // BRR is calculated from current clocks
+}
+/**
+ * @brief Starts DMA transfer of next span of data.
+ * @param port Port number
+ * @param sent Number of bytes sent in previous transfer
+ */
+static void UART_TxNext(uint8_t port, uint16_t sent) {
+
+  const UART_Hw_TypeDef* hw = &uartHw[port];
+  UART_State_TypeDef* state = &uartState[port];
+  uint8_t* buf;
+
+  // get data from higher layer using callback
+  state->txLen = state->txCallback(state->ctx, sent, &buf);
+
+  if (state->txLen == 0) { // if no more data to send transmitter goes idle
+    return;
+  }
+
+  // TC left set by previous transfer would let baud rate changes
+  // cut off the last bytes of this one
+  USART_ClearFlag(hw->usart, USART_FLAG_TC);
+
+  DMA_ClearFlag(hw->txStream, hw->txFlags);
+  DMA_MemoryTargetConfig(hw->txStream, (uint32_t)buf, DMA_Memory_0);
+  DMA_SetCurrDataCounter(hw->txStream, state->txLen);
+  DMA_Cmd(hw->txStream, ENABLE);
+}
+/**
+ * @brief Enable transmitter.
+ * @details This function has to be called by the higher layer
+ * in order to start the transmitter. It does nothing if a
+ * transfer is in progress - the transfer complete interrupt
+ * picks up new data.
+ * @param port Port number
+ */
+void UART_TxEnable(uint8_t port) {
+
+  if (!uartState[port].txCallback) { // if NULL
+    return;
+  }
+
+  // transfer complete interrupt can't run between check and start
+  uint32_t lock = CRITICAL_Enter();
+
+  if (uartState[port].txLen == 0) {
+    UART_TxNext(port, 0);
+  }
+
+  CRITICAL_Exit(lock);
+}
+/**
+ * @brief Handles TX DMA stream interrupt.
+ * @param port Port number
+ */
+static void UART_TxIrq(uint8_t port) {
+
+  const UART_Hw_TypeDef* hw = &uartHw[port];
+
+  // If transfer complete interrupt
+  if (DMA_GetITStatus(hw->txStream, hw->txTcIt) != RESET) {
+
+    DMA_ClearITPendingBit(hw->txStream, hw->txTcIt);
+
+    UART_TxNext(port, uartState[port].txLen); // free sent data and send more
+  }
+}
+/**
+ * @brief Passes newly received data to higher layer.
+ * @details Called from idle line and DMA half/full transfer
+ * interrupts. These have the same priority, so they don't
+ * preempt each other.
+ * @param port Port number
+ */
+static void UART_RxPublish(uint8_t port) {
+
+  UART_State_TypeDef* state = &uartState[port];
+
+  // DMA write position in circular buffer
+  uint16_t pos = UART_RX_BUF_LEN - DMA_GetCurrDataCounter(uartHw[port].rxStream);
+
+  if (pos == UART_RX_BUF_LEN) {
+    pos = 0;
+  }
+
+  if (pos == state->rxPos || !state->rxCallback) {
+    return;
+  }
+
+  if (pos > state->rxPos) {
+    state->rxCallback(state->ctx, &state->rxBuffer[state->rxPos], pos - state->rxPos);
+  } else { // data wraps around end of buffer
+    state->rxCallback(state->ctx, &state->rxBuffer[state->rxPos], UART_RX_BUF_LEN - state->rxPos);
+    if (pos) {
+      state->rxCallback(state->ctx, state->rxBuffer, pos);
+    }
+  }
+
+  state->rxPos = pos;
+}
+/**
+ * @brief Handles RX DMA stream interrupt.
+ * @param port Port number
+ */
+static void UART_RxIrq(uint8_t port) {
+
+  const UART_Hw_TypeDef* hw = &uartHw[port];
+
+  // If half transfer interrupt
+  if (DMA_GetITStatus(hw->rxStream, hw->rxHtIt) != RESET) {
+    DMA_ClearITPendingBit(hw->rxStream, hw->rxHtIt);
+    UART_RxPublish(port);
+  }
+
+  // If transfer complete interrupt
+  if (DMA_GetITStatus(hw->rxStream, hw->rxTcIt) != RESET) {
+    DMA_ClearITPendingBit(hw->rxStream, hw->rxTcIt);
+    UART_RxPublish(port);
+  }
+}
+/**
+ * @brief Handles USART interrupt.
+ * @param port Port number
+ */
+static void UART_Irq(uint8_t port) {
+
+  USART_TypeDef* usart = uartHw[port].usart;
+
+  // If idle line interrupt - sender paused, pass on what we have
+  if (USART_GetITStatus(usart, USART_IT_IDLE) != RESET) {
+
+    // flag is cleared by reading SR followed by DR
+    (void)usart->SR;
+    (void)usart->DR;
+
+    UART_RxPublish(port);
+  }
+}
+
+/**
+ * @brief IRQ handler for USART1
+ */
+void USART1_IRQHandler(void) {
+  UART_Irq(UART_PORT1);
+}
+/**
+ * @brief IRQ handler for USART1 TX DMA stream
+ */
+void DMA2_Stream7_IRQHandler(void) {
+  UART_TxIrq(UART_PORT1);
+}
+/**
+ * @brief IRQ handler for USART1 RX DMA stream
+ */
+void DMA2_Stream2_IRQHandler(void) {
+  UART_RxIrq(UART_PORT1);
+}
+/**
+ * @brief IRQ handler for USART2
+ */
+void USART2_IRQHandler(void) {
+  UART_Irq(UART_PORT2);
+}
+/**
+ * @brief IRQ handler for USART2 TX DMA stream
+ */
+void DMA1_Stream6_IRQHandler(void) {
+  UART_TxIrq(UART_PORT2);
+}
+/**
+ * @brief IRQ handler for USART2 RX DMA stream
+ */
+void DMA1_Stream5_IRQHandler(void) {
+  UART_RxIrq(UART_PORT2);
+}
+/**
+ * @brief IRQ handler for USART3
+ */
+void USART3_IRQHandler(void) {
+  UART_Irq(UART_PORT3);
+}
+/**
+ * @brief IRQ handler for USART3 TX DMA stream
+ */
+void DMA1_Stream3_IRQHandler(void) {
+  UART_TxIrq(UART_PORT3);
+}
+/**
+ * @brief IRQ handler for USART3 RX DMA stream
+ */
+void DMA1_Stream1_IRQHandler(void) {
+  UART_RxIrq(UART_PORT3);
+}
+/**
+ * @brief IRQ handler for USART6
+ */
+void USART6_IRQHandler(void) {
+  UART_Irq(UART_PORT6);
+}
+/**
+ * @brief IRQ handler for USART6 TX DMA stream
+ */
+void DMA2_Stream6_IRQHandler(void) {
+  UART_TxIrq(UART_PORT6);
+}
+/**
+ * @brief IRQ handler for USART6 RX DMA stream
+ */
+void DMA2_Stream1_IRQHandler(void) {
+  UART_RxIrq(UART_PORT6);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,223 @@
+/**
+ * @file:   comm_fuzz.c
+ * @brief:  Host random input test of COMM frame extraction
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @details Random frames, including empty frames, frames at the
+ * COMM_FRAME_MAX limit and oversize frames, are fed to a channel
+ * in random chunks, interleaved with a random number of
+ * COMM_ChannelGetFrameRef calls. Every frame up to the limit has
+ * to come out intact and in order, every oversize frame has to be
+ * counted exactly once in framesDropped and the parser has to
+ * resync on the next frame. The small RX buffer makes frames wrap
+ * around its end, which is checked too.
+ *
+ * Usage: comm_fuzz [seed] [iterations]
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <comm.h>
+#include <uart.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RX_LEN        1024  ///< RX buffer length (power of two)
+#define TX_LEN        64    ///< TX buffer length (not used)
+#define FRAMES        200   ///< Frames per iteration
+#define MAX_STREAM    (FRAMES * (3 * COMM_FRAME_MAX + 1))
+#define TERMINATOR    '\r'
+
+void* uartStubCtx[UART_STUB_PORTS];
+void (*uartStubRx[UART_STUB_PORTS])(void*, uint8_t*, uint16_t);
+
+/**
+ * @brief Host stub of microsecond time.
+ */
+uint32_t HRTIMER_GetTime(void) {
+
+  static uint32_t time;
+  return time += 10;
+}
+/**
+ * @brief Host stub of idle wait.
+ */
+void TIMER_Idle(void) {
+
+}
+
+static COMM_Channel_TypeDef channel;
+static uint8_t rxBuffer[RX_LEN];
+static uint8_t txBuffer[TX_LEN];
+
+static uint8_t stream[MAX_STREAM];        ///< Input data
+static uint32_t frameStart[FRAMES];       ///< Offsets of expected frames in stream
+static uint16_t frameLen[FRAMES];         ///< Lengths of expected frames
+
+static uint32_t wrapped;  ///< Frames copied because they wrapped around buffer end
+
+/**
+ * @brief Draws frame length - mostly short, often at the limit.
+ */
+static uint16_t TEST_FrameLen(void) {
+
+  switch (rand() % 8) {
+  case 0:
+    return 0;
+  case 1:
+    return COMM_FRAME_MAX - 1 - rand() % 2;  // longest valid frames
+  case 2:
+    return COMM_FRAME_MAX + rand() % 2;      // shortest oversize frames
+  case 3:
+    return COMM_FRAME_MAX + rand() % (2 * COMM_FRAME_MAX); // oversize
+  default:
+    return rand() % 64;
+  }
+}
+/**
+ * @brief Gets frames from channel and checks them.
+ * @param polls Number of calls
+ * @param got Number of frames received so far (updated)
+ * @param expected Number of frames expected
+ * @retval 0 Frames correct
+ * @retval 1 Error: frame wrong or not expected
+ */
+static uint8_t TEST_Poll(uint16_t polls, uint16_t* got, uint16_t expected) {
+
+  uint8_t* frame;
+  uint16_t len;
+
+  while (polls--) {
+    if (COMM_ChannelGetFrameRef(&channel, &frame, &len) != 0) {
+      continue;
+    }
+
+    if (*got >= expected || len != frameLen[*got] ||
+        memcmp(frame, &stream[frameStart[*got]], len) || frame[len] != 0) {
+      printf("COMM fuzz: frame %u wrong\n", (unsigned int)*got);
+      return 1;
+    }
+    if (frame == channel.frameBuffer) {
+      wrapped++;
+    }
+
+    (*got)++;
+    COMM_ChannelReleaseFrame(&channel);
+  }
+
+  return 0;
+}
+/**
+ * @brief Runs one iteration.
+ * @retval 0 Iteration passed
+ * @retval 1 Iteration failed
+ */
+static uint8_t TEST_Iteration(void) {
+
+  COMM_Stats_TypeDef stats;
+  uint32_t len = 0;
+  uint32_t pos = 0;
+  uint16_t expected = 0;
+  uint16_t got = 0;
+  uint32_t dropped = 0;
+  uint16_t i, k;
+
+  COMM_ChannelGetStats(&channel, &stats);
+  uint32_t droppedBefore = stats.framesDropped;
+
+  // build input
+  for (i = 0; i < FRAMES; i++) {
+    uint16_t frame = TEST_FrameLen();
+
+    if (frame < COMM_FRAME_MAX) {
+      frameStart[expected] = len;
+      frameLen[expected] = frame;
+      expected++;
+    } else {
+      dropped++;
+    }
+
+    for (k = 0; k < frame; k++) {
+      uint8_t c;
+      do {
+        c = rand();
+      } while (c == TERMINATOR);
+      stream[len++] = c;
+    }
+    stream[len++] = TERMINATOR;
+  }
+
+  // feed in random chunks, never more than fits (no RX overflow)
+  while (pos < len) {
+    uint16_t chunk = 1 + rand() % 96;
+    uint16_t free = FIFO_GetFree(&channel.rxFifo);
+
+    if (chunk > len - pos) {
+      chunk = len - pos;
+    }
+    if (chunk > free) {
+      chunk = free;
+    }
+
+    UART_STUB_Receive(channel.port, &stream[pos], chunk);
+    pos += chunk;
+
+    if (TEST_Poll(rand() % 3, &got, expected)) {
+      return 1;
+    }
+  }
+
+  // get the rest
+  if (TEST_Poll(2 * FRAMES, &got, expected)) {
+    return 1;
+  }
+
+  COMM_ChannelGetStats(&channel, &stats);
+
+  if (got != expected || stats.framesDropped - droppedBefore != dropped ||
+      stats.rxDropped || !FIFO_IsEmpty(&channel.rxFifo)) {
+    printf("COMM fuzz: got %u/%u frames, dropped %u/%u\n",
+        (unsigned int)got, (unsigned int)expected,
+        (unsigned int)(stats.framesDropped - droppedBefore), (unsigned int)dropped);
+    return 1;
+  }
+
+  return 0;
+}
+
+int main(int argc, char** argv) {
+
+  unsigned int seed = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1;
+  unsigned int iterations = (argc > 2) ? strtoul(argv[2], NULL, 0) : 500;
+  unsigned int i;
+
+  srand(seed);
+
+  COMM_ChannelInit(&channel, 1, 115200, rxBuffer, RX_LEN, txBuffer, TX_LEN);
+
+  for (i = 0; i < iterations; i++) {
+    if (TEST_Iteration()) {
+      printf("COMM fuzz: failed in iteration %u (seed %u)\n", i, seed);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!wrapped) {
+    printf("COMM fuzz: no frame wrapped around buffer end\n");
+    return EXIT_FAILURE;
+  }
+
+  printf("COMM fuzz: %u iterations OK (%u wrapped frames, seed %u)\n",
+      iterations, (unsigned int)wrapped, seed);
+  return EXIT_SUCCESS;
+}
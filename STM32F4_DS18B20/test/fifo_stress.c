@@ -0,0 +1,282 @@
+/**
+ * @file:   fifo_stress.c
+ * @brief:  Host stress test of FIFO with concurrent producer and consumer
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @details A producer thread and the main (consumer) thread move
+ * a known byte sequence through a small FIFO, so the indices wrap
+ * many times. Both sides mix single byte, bulk and span (in place)
+ * functions. Every byte is checked and the checksums of both sides
+ * have to match. The second part checks that with FIFO_DROP_OLDEST
+ * every byte is either received or counted as dropped.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <fifo.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FIFO_LEN    256       ///< Small buffer - indices wrap often
+#define TOTAL       20000000  ///< Number of bytes sent
+#define MAX_CHUNK   67        ///< Maximum bulk transfer length
+
+static uint8_t buffer[FIFO_LEN];
+static FIFO_TypeDef fifo;
+
+static uint32_t producerSum; ///< Checksum of sent bytes
+
+/**
+ * @brief Byte number i of the test sequence.
+ */
+static uint8_t TEST_Byte(uint32_t i) {
+
+  return (i * 2654435761u) >> 24;
+}
+/**
+ * @brief Adds byte to checksum (Fletcher-32 like, order sensitive).
+ */
+static void TEST_Sum(uint32_t* sum, uint8_t c) {
+
+  uint16_t a = *sum + c;
+  uint16_t b = (*sum >> 16) + a;
+  *sum = ((uint32_t)b << 16) | a;
+}
+/**
+ * @brief Simple per thread random number generator.
+ */
+static uint32_t TEST_Rand(uint32_t* state) {
+
+  *state = *state * 1103515245 + 12345;
+  return *state >> 8;
+}
+/**
+ * @brief Producer - pushes whole sequence, waits when FIFO is full.
+ */
+static void* TEST_Producer(void* arg) {
+
+  uint32_t seed = 1;
+  uint32_t i = 0;
+  uint8_t chunk[MAX_CHUNK];
+  FIFO_Span_TypeDef span[2];
+
+  while (i < TOTAL) {
+
+    uint16_t want = 1 + TEST_Rand(&seed) % MAX_CHUNK;
+    uint16_t done = 0;
+    uint16_t k;
+
+    if (want > TOTAL - i) {
+      want = TOTAL - i;
+    }
+
+    switch (TEST_Rand(&seed) % 3) {
+    case 0: // single byte
+      done = !FIFO_Push(&fifo, TEST_Byte(i));
+      break;
+
+    case 1: // bulk copy
+      for (k = 0; k < want; k++) {
+        chunk[k] = TEST_Byte(i + k);
+      }
+      done = FIFO_PushBuf(&fifo, chunk, want);
+      break;
+
+    case 2: // in place, in two spans
+      FIFO_Reserve2(&fifo, span);
+      for (k = 0; k < want && k < span[0].len + span[1].len; k++) {
+        if (k < span[0].len) {
+          span[0].buf[k] = TEST_Byte(i + k);
+        } else {
+          span[1].buf[k - span[0].len] = TEST_Byte(i + k);
+        }
+      }
+      FIFO_Commit(&fifo, k);
+      done = k;
+      break;
+    }
+
+    for (k = 0; k < done; k++) {
+      TEST_Sum(&producerSum, TEST_Byte(i + k));
+    }
+    i += done;
+
+    if (!done) {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+/**
+ * @brief Checks received bytes.
+ * @retval 0 Bytes are correct
+ * @retval 1 Error: wrong byte
+ */
+static uint8_t TEST_Check(const uint8_t* buf, uint16_t len, uint32_t* i, uint32_t* sum) {
+
+  uint16_t k;
+
+  for (k = 0; k < len; k++) {
+    if (buf[k] != TEST_Byte(*i)) {
+      printf("FIFO stress: wrong byte %u\n", (unsigned int)*i);
+      return 1;
+    }
+    TEST_Sum(sum, buf[k]);
+    (*i)++;
+  }
+
+  return 0;
+}
+/**
+ * @brief Lossless transfer with FIFO_DROP_NEWEST (producer waits).
+ * @retval 0 Test passed
+ * @retval 1 Test failed
+ */
+static uint8_t TEST_Lossless(void) {
+
+  pthread_t producer;
+  uint32_t seed = 2;
+  uint32_t i = 0;
+  uint32_t sum = 0;
+  uint8_t chunk[MAX_CHUNK];
+  uint8_t* span;
+  uint16_t len = 0;
+
+  fifo.buf = buffer;
+  fifo.len = FIFO_LEN;
+  FIFO_Add(&fifo);
+
+  pthread_create(&producer, NULL, TEST_Producer, NULL);
+
+  while (i < TOTAL) {
+
+    uint16_t want = 1 + TEST_Rand(&seed) % MAX_CHUNK;
+    uint8_t ok = 0;
+
+    switch (TEST_Rand(&seed) % 4) {
+    case 0: // single byte
+      len = !FIFO_Pop(&fifo, chunk);
+      ok = TEST_Check(chunk, len, &i, &sum);
+      break;
+
+    case 1: // bulk copy
+      len = FIFO_PopBuf(&fifo, chunk, want);
+      ok = TEST_Check(chunk, len, &i, &sum);
+      break;
+
+    case 2: // in place
+      len = FIFO_GetSpan(&fifo, &span);
+      ok = TEST_Check(span, len, &i, &sum);
+      FIFO_Discard(&fifo, len);
+      break;
+
+    case 3: // peek, then discard
+      len = FIFO_PeekBuf(&fifo, 0, chunk, want);
+      ok = TEST_Check(chunk, len, &i, &sum);
+      FIFO_Discard(&fifo, len);
+      break;
+    }
+
+    if (ok) {
+      return 1;
+    }
+    if (!len) {
+      sched_yield();
+    }
+  }
+
+  pthread_join(producer, NULL);
+
+  // refused pushes count as dropped, but the producer retried them
+  if (sum != producerSum || !FIFO_IsEmpty(&fifo)) {
+    printf("FIFO stress: checksum %08x, expected %08x\n",
+        (unsigned int)sum, (unsigned int)producerSum);
+    return 1;
+  }
+
+  printf("FIFO stress: %u bytes OK\n", (unsigned int)TOTAL);
+  return 0;
+}
+
+static atomic_bool producerDone; ///< Overwriting producer finished
+
+/**
+ * @brief Producer - pushes without waiting, oldest data is dropped.
+ */
+static void* TEST_OverwriteProducer(void* arg) {
+
+  uint32_t seed = 3;
+  uint32_t i = 0;
+  uint8_t chunk[MAX_CHUNK] = {0};
+
+  while (i < TOTAL) {
+    uint16_t want = 1 + TEST_Rand(&seed) % MAX_CHUNK;
+    if (want > TOTAL - i) {
+      want = TOTAL - i;
+    }
+    i += FIFO_PushBuf(&fifo, chunk, want); // all of it goes in
+  }
+
+  atomic_store_explicit(&producerDone, 1, memory_order_release);
+
+  return NULL;
+}
+/**
+ * @brief Transfer with FIFO_DROP_OLDEST - nothing is lost uncounted.
+ * @retval 0 Test passed
+ * @retval 1 Test failed
+ */
+static uint8_t TEST_Overwrite(void) {
+
+  pthread_t producer;
+  uint32_t seed = 4;
+  uint32_t got = 0;
+  uint8_t chunk[MAX_CHUNK];
+
+  fifo.buf = buffer;
+  fifo.len = FIFO_LEN;
+  FIFO_Add(&fifo);
+  fifo.policy = FIFO_DROP_OLDEST;
+
+  pthread_create(&producer, NULL, TEST_OverwriteProducer, NULL);
+
+  while (!atomic_load_explicit(&producerDone, memory_order_acquire) ||
+      !FIFO_IsEmpty(&fifo)) {
+    got += FIFO_PopBuf(&fifo, chunk, 1 + TEST_Rand(&seed) % MAX_CHUNK);
+  }
+
+  pthread_join(producer, NULL);
+
+  if (got + FIFO_GetDropped(&fifo) != TOTAL) {
+    printf("FIFO overwrite: got %u + dropped %u, expected %u\n",
+        (unsigned int)got, (unsigned int)FIFO_GetDropped(&fifo),
+        (unsigned int)TOTAL);
+    return 1;
+  }
+
+  printf("FIFO overwrite: %u bytes, %u dropped OK\n", (unsigned int)TOTAL,
+      (unsigned int)FIFO_GetDropped(&fifo));
+  return 0;
+}
+
+int main(void) {
+
+  if (TEST_Lossless() || TEST_Overwrite()) {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,24 @@
+/**
+ * @file:   log.h
+ * @brief:  Host test stub - log messages are dropped
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef LOG_H_
+#define LOG_H_
+
+#define LOG(fmt, args...) (void)0
+#define LOG_STR(fmt, str, args...) (void)0
+
+#endif /* LOG_H_ */
@@ -0,0 +1,43 @@
+/**
+ * @file:   uart.h
+ * @brief:  Host test stub - lower layer of COMM
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @details Ports only remember their channel and RX callback,
+ * so tests can feed received data with UART_STUB_Receive.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef UART_H_
+#define UART_H_
+
+#include <inttypes.h>
+
+#define UART_STUB_PORTS 4
+
+extern void* uartStubCtx[UART_STUB_PORTS];
+extern void (*uartStubRx[UART_STUB_PORTS])(void*, uint8_t*, uint16_t);
+
+#define UART_STUB_Receive(port, buf, len) uartStubRx[port](uartStubCtx[port], buf, len)
+
+#define COMM_HAL_PORTS            UART_STUB_PORTS
+#define COMM_HAL_CONSOLE          0
+#define COMM_HAL_Init(port, baud, ctx, rxCb, txCb) \
+  (uartStubCtx[port] = (ctx), uartStubRx[port] = (rxCb), (void)(txCb))
+#define COMM_HAL_TxEnable(port)         (void)0
+#define COMM_HAL_UpdateClock(port)      (void)0
+#define COMM_HAL_SetBaud(port, baud)    (baud)
+#define COMM_HAL_GetBaud(port)          0
+#define COMM_HAL_CalcBaud(port, baud)   (baud)
+
+#endif /* UART_H_ */
@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""
+Host side decoder for binary telemetry frames (see app/src/telemetry.c).
+
+Reads COBS framed data from a serial port (or a capture file), checks
+the CRC and prints sensor samples and deferred log messages. Log format
+strings are looked up by address in the firmware ELF file.
+
+Usage:
+    telemetry.py --port /dev/ttyUSB0 --elf Debug/STM32F4_DS18B20.elf
+    telemetry.py --file capture.bin --elf Debug/STM32F4_DS18B20.elf
+
+Requires pyserial (for --port) and pyelftools (for --elf).
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+TYPE_SAMPLES = 0x01
+TYPE_LOG = 0x02
+TYPE_HISTORY = 0x03
+
+
+def stm32_crc(data):
+    """CRC-32 as calculated by the STM32F4 CRC unit (see hal/src/crc_hal.c)."""
+    if len(data) % 4:
+        data = data + bytes(4 - len(data) % 4)
+    crc = 0xFFFFFFFF
+    for (word,) in struct.iter_unpack("<I", data):
+        crc ^= word
+        for _ in range(32):
+            if crc & 0x80000000:
+                crc = ((crc << 1) ^ 0x04C11DB7) & 0xFFFFFFFF
+            else:
+                crc = (crc << 1) & 0xFFFFFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            raise ValueError("invalid COBS data")
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class FormatStrings:
+    """Reads constant strings from the firmware ELF file by address."""
+
+    def __init__(self, path):
+        self.sections = []
+        if path is None:
+            return
+        from elftools.elf.elffile import ELFFile
+        with open(path, "rb") as f:
+            elf = ELFFile(f)
+            for sec in elf.iter_sections():
+                if sec["sh_addr"] and sec["sh_type"] == "SHT_PROGBITS":
+                    self.sections.append((sec["sh_addr"], sec.data()))
+
+    def get(self, addr):
+        for start, data in self.sections:
+            if start <= addr < start + len(data):
+                end = data.index(b"\0", addr - start)
+                return data[addr - start:end].decode("ascii", "replace")
+        return None
+
+
+def c_format(fmt, args, strings=None):
+    """Formats a printf style string with 32 bit integer arguments.
+
+    Arguments are unsigned, only %d and %i reinterpret them as signed.
+    %s takes a string copied into the record, or the address of a
+    constant string in the firmware.
+    """
+    values = []
+
+    def conversion(match):
+        if match.group(0) == "%%":
+            return "%%"
+        flags, kind = match.group(1), match.group(2)
+        if len(values) < len(args):
+            value = args[len(values)]
+            if kind == "s" and not isinstance(value, str):
+                text = strings.get(value) if strings else None
+                value = text if text is not None else "<0x%08x>" % value
+            elif kind in "di" and value & 0x80000000:
+                value -= 1 << 32
+            values.append(value)
+        return "%" + flags + ("d" if kind in "iu" else kind)
+
+    fmt = re.sub(r"%%|%([-+ #0]*\d*)l{0,2}([diuxXcs])", conversion, fmt)
+    try:
+        return fmt % tuple(values)
+    except (TypeError, ValueError):
+        return fmt + " " + repr(args)
+
+
+def decode_samples(seq, payload):
+    for time, temp, sensor in struct.iter_unpack("<IhB", payload):
+        print("[%5d] %10d ms sensor %d: %.4f C" % (seq, time, sensor, temp / 16.0))
+
+
+def decode_history(seq, payload):
+    sensor, first = struct.unpack_from("<BI", payload)
+    for i, (time, temp, _) in enumerate(struct.iter_unpack("<IhB", payload[5:])):
+        print("[%5d] %10d ms sensor %d sample %d: %.4f C" % (seq, time, sensor, first + i, temp / 16.0))
+
+
+def decode_log(seq, payload, strings):
+    i = 0
+    while i + 9 <= len(payload):
+        nargs, addr, time = struct.unpack_from("<BII", payload, i)
+        i += 9
+        copied = nargs & 0x80  # first argument is length of copied string
+        nargs &= 0x7f
+        args = list(struct.unpack_from("<%dI" % nargs, payload, i))
+        i += 4 * nargs
+        if copied and args:
+            args[0] = payload[i:i + args[0]].decode("ascii", "replace")
+            i += len(args[0])
+        fmt = strings.get(addr)
+        if fmt is None:
+            text = "<format 0x%08x> %r" % (addr, args)
+        else:
+            text = c_format(fmt, args, strings).rstrip("\r\n")
+        print("[%5d] %10d ms %s" % (seq, time, text))
+
+
+def handle_frame(raw, strings, state):
+    try:
+        frame = cobs_decode(raw)
+    except ValueError:
+        frame = b""
+    if len(frame) < 7 or stm32_crc(frame[:-4]) != struct.unpack("<I", frame[-4:])[0]:
+        # not a frame - probably text output
+        text = raw.decode("ascii", "replace").strip()
+        if text:
+            print(text)
+        return
+    ftype, seq = struct.unpack_from("<BH", frame)
+    if state.get("seq") is not None and seq != (state["seq"] + 1) & 0xFFFF:
+        print("--- lost %d frame(s)" % ((seq - state["seq"] - 1) & 0xFFFF))
+    state["seq"] = seq
+    payload = frame[3:-4]
+    if ftype == TYPE_SAMPLES:
+        decode_samples(seq, payload)
+    elif ftype == TYPE_LOG:
+        decode_log(seq, payload, strings)
+    elif ftype == TYPE_HISTORY:
+        decode_history(seq, payload)
+    else:
+        print("[%5d] unknown frame type 0x%02x: %s" % (seq, ftype, payload.hex()))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument("--port", help="serial port")
+    src.add_argument("--file", help="capture file")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--elf", help="firmware ELF file (for log messages)")
+    args = parser.parse_args()
+
+    strings = FormatStrings(args.elf)
+
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud)
+    else:
+        stream = open(args.file, "rb")
+
+    state = {}
+    buf = bytearray()
+    while True:
+        data = stream.read(1 if args.port else 4096)
+        if not data:
+            break
+        buf += data
+        while b"\0" in buf:
+            end = buf.index(b"\0")
+            handle_frame(bytes(buf[:end]), strings, state)
+            del buf[:end + 1]
+            sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()